@@ -10,6 +10,7 @@
 #include "freertos/task.h"
 
 #include "inc/nRF24.h"
+#include "inc/nRF24_ring.h"
 
 /* 
     Current setup: 
@@ -19,11 +20,12 @@
         MISO: D19
         CE:   D4
         CSN:  D5
-        IRQ:  D34 - Not used in this example. 
+        IRQ:  D34 - Wakes the receiver, see nRF24_attachIrq. 
 */
 
 #define CSN_PIN     5u
 #define CE_PIN      4u
+#define IRQ_PIN     34u
 
 #define SPI_SPEED   10 *1000 *1000
 #define SPI_PORT    2u 
@@ -31,6 +33,9 @@
 
 #define SIZE NRF24_MAX_PAYLOAD_SIZE
 
+/* Frames buffered between the radio (mainTask) and the application (appTask). */
+#define RX_RING_DEPTH 16u
+
 /* Addresses, should be same width/length as the nRF24_setAddressWidth() */
 uint8_t address[][6] = { "1Node", "2Node" };
 nrf24_cfg_t config = NRF24_DEFAULT_CFG(CSN_PIN, CE_PIN);
@@ -38,6 +43,11 @@ nrf24_cfg_t config = NRF24_DEFAULT_CFG(CSN_PIN, CE_PIN);
 /* Use the extern *machine pointer.  */
 extern const machine_t *machine; 
 static spi_handle_t *_spi2;  
+static nrf24_t      *radio;
+static TaskHandle_t  mainTaskHandle;
+
+static nrf24_rx_frame_t rxSlots[RX_RING_DEPTH];
+static nrf24_ring_t     rxRing;
 
 /* Determine if the current node is master or not. */
 bool master      = false; 
@@ -48,8 +58,16 @@ uint32_t totalBytes = 0;
 uint32_t lastBytes = 0;
 
 void mainTask(void *arg);
+void appTask(void *arg);
 void statsTask(void *arg);
 
+/* Runs in the ISR of the IRQ pin, only wake the mainTask. */
+static void onIrq(void *arg){
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(mainTaskHandle, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
 void app_main(void){
     /* Wait for the chip to settle.  */
     (void)vTaskDelay(15u);
@@ -62,7 +80,7 @@ void app_main(void){
     machine->gpio.config(22u, false);
 
     /* Initialize the chip, and set the set configuration. */
-    if (nRF24_init(_spi2, &config) != NRF24_OK){
+    if (nRF24_init(&radio, _spi2, &config) != NRF24_OK){
         printf("[main] - nRF24_init failed. \r\n");
         for (;;) {
             /* Loop forever.. */
@@ -72,7 +90,7 @@ void app_main(void){
     }
 
     /* Check if Chip is connected.  */
-    if (nRF24_isConnected(&isConnected) != NRF24_OK){
+    if (nRF24_isConnected(radio, &isConnected) != NRF24_OK){
         printf("[main] - Could't .isConnected. \r\n");
     }
     else if (!isConnected){
@@ -89,20 +107,21 @@ void app_main(void){
         master = true; 
     }
 
-    /* Demo - Set other configurations */
-    (void)nRF24_setDataRate(NRF24_1MBPS);
-    (void)nRF24_setAddressWidth(5u);
-    (void)nRF24_setPALevel(NRF24_PA_MIN, true);
-    (void)nRF24_setAutoAck(false);
-    (void)nRF24_setCrcLength(NRF24_CRC_8);
-
-    (void)nRF24_setChannel(100u);
-    (void)nRF24_setPayloadSize(SIZE);
+    /* Demo - Set other configurations, only the registers that changed are written. */
+    config.datarate      = NRF24_1MBPS;
+    config.addressWidth  = 5u;
+    config.PA.level      = NRF24_PA_MIN;
+    config.PA.lnaEnabled = true;
+    config.ack.autoAck   = false;
+    config.crc           = NRF24_CRC_8;
+    config.channel       = 100u;
+    config.payloadSize   = SIZE;
+    (void)nRF24_applyConfig(radio, &config);
 
     /* Open writing and reading pipes. */
-    (void)nRF24_openWritingPipe(address[!master]);
-    (void)nRF24_stopListening();
-    (void)nRF24_openReadingPipe(1, (const uint8_t *)address[master]);
+    (void)nRF24_openWritingPipe(radio, address[!master]);
+    (void)nRF24_stopListening(radio);
+    (void)nRF24_openReadingPipe(radio, 1, (const uint8_t *)address[master]);
 
     xTaskCreate(mainTask, "mainTask", 4096, NULL, 1, NULL);
     xTaskCreate(statsTask, "statsTask", 4096, NULL, 2, NULL);
@@ -115,19 +134,24 @@ void mainTask(void *arg){
     double accumulatedBytes = 0;
 
     if (!master){
-        (void)nRF24_startListening(); 
-        (void)nRF24_flushRx();
+        /* Sleep until the IRQ pin falls, instead of polling SPI. */
+        mainTaskHandle = xTaskGetCurrentTaskHandle();
+        /* RX_DR drains the RX FIFO into rxRing, appTask processes it at its own pace. */
+        (void)nRF24_ringInit(&rxRing, rxSlots, RX_RING_DEPTH);
+        (void)nRF24_onEvent(radio, NRF24_RX_DR, nRF24_ringRxHandler, &rxRing);
+        xTaskCreate(appTask, "appTask", 4096, NULL, 1, NULL);
+        (void)nRF24_attachIrq(radio, IRQ_PIN, onIrq, NULL);
+
+        (void)nRF24_startListening(radio); 
+        (void)nRF24_flushRx(radio);
 
-        uint8_t *buffer = (uint8_t *)malloc((sizeof(uint8_t) * SIZE + 1u)); 
         for (;;){
-            if (nRF24_available()){
-                (void)nRF24_read(buffer, SIZE);
-                totalBytes += SIZE;
-            }
+            (void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            (void)nRF24_update(radio);
         }
     }
     else {
-        (void)nRF24_flushTx();
+        (void)nRF24_flushTx(radio);
 
         uint8_t  buff_item = 0u;
         uint8_t *buffer    = (uint8_t *)malloc(sizeof(uint8_t) * SIZE + 1u);
@@ -159,14 +183,28 @@ void mainTask(void *arg){
             (void)memset(buffer, buff_item, SIZE);
             buff_item = (buff_item + 1u) % 250u; 
             
-            (void)nRF24_fastWrite(buffer, SIZE, false);
+            (void)nRF24_fastWrite(radio, buffer, SIZE, false);
             totalBytes += 32u; 
         }
     }
 }
 
+/* Consumer of rxRing, the frames are handled in place. */
+void appTask(void *arg){
+    nrf24_rx_frame_t *frame = NULL;
+
+    for (;;){
+        while ((frame = nRF24_ringPeek(&rxRing)) != NULL){
+            totalBytes += frame->length;
+            nRF24_ringRelease(&rxRing);
+        }
+        (void)vTaskDelay(1u);
+    }
+}
+
 void statsTask(void *arg) {
-    TickType_t lastWakeTime = xTaskGetTickCount();
+    TickType_t    lastWakeTime = xTaskGetTickCount();
+    nrf24_stats_t stats;
 
     for (;;) {
         vTaskDelayUntil(&lastWakeTime, pdMS_TO_TICKS(1000));
@@ -174,6 +212,17 @@ void statsTask(void *arg) {
         uint32_t diff = (totalBytes - lastBytes);
         lastBytes = totalBytes;
 
-        printf("[Stats] Data rate: %lu bytes/s (total: %lu)\r\n", (unsigned long)diff, (unsigned long)totalBytes);
+        printf("[Stats] Data rate: %lu bytes/s (total: %lu, dropped: %lu)\r\n", (unsigned long)diff, 
+            (unsigned long)totalBytes, (unsigned long)(master ? 0u : nRF24_ringDropped(&rxRing)));
+
+        /* A snapshot of the driver counters, no SPI traffic. */
+        (void)nRF24_getStats(radio, &stats);
+        if (master){
+            printf("[Stats] TX: %lu payloads, %lu MAX_RT, %lu lost\r\n", (unsigned long)stats.tx_payloads, 
+                (unsigned long)stats.tx_max_rt, (unsigned long)stats.lost);
+        } else {
+            printf("[Stats] RX: %lu payloads, RX FIFO full: %lu\r\n", (unsigned long)stats.rx_payloads[1], 
+                (unsigned long)stats.rx_full);
+        }
     }
 }
\ No newline at end of file
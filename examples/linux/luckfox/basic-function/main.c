@@ -5,19 +5,40 @@
 
 #include "inc/nRF24.h"
 
+/* The IRQ pin of the radio, the main loop sleeps until it falls. */
+#define IRQ_PIN 56u
+
 static spi_handle_t     *_spi2;  
+static nrf24_t          *radio;
 extern const machine_t  *machine;
 
+/* CSN on GPIO 54. With CSN wired to the CS of /dev/spidev0.0 use SPI_HW_CS instead, spidev then toggles it. */
 nrf24_cfg_t config       = NRF24_DEFAULT_CFG(54, 55);
 uint8_t     address[][6] = { "1Node", "2Node" }; /* A 5 byte wide node address. */
 bool        isConnected  = false; 
 bool        isMaster     = false;  /* Default to RX */
 
-uint8_t  buffer[32u + 1u]; 
+nrf24_rx_frame_t frames[3u]; /* The RX FIFO is 3 payloads deep. */
+size_t           received = 0u;
 uint32_t lastShown  = 0;
 uint32_t totalBytes = 0;
 uint32_t lastBytes  = 0;
+nrf24_stats_t stats;
+nrf24_histogram_t spiTime;
+nrf24_histogram_t transactionTime;
+uint32_t          p50, p99;
 
+/* Runs from nRF24_update, drain all available packets in one go. */
+static void onReceive(nrf24_t *radio, nrf24_irq_flags_t event, void *arg){
+    (void)event;
+    (void)arg;
+
+    if (nRF24_readBurst(radio, frames, 3u, &received) == NRF24_OK){
+        for (size_t idx = 0u; idx < received; ++idx){
+            totalBytes += frames[idx].length; 
+        }
+    }
+}
 
 int main(){
     int      res    = 0;
@@ -27,7 +48,7 @@ int main(){
     _spi2 = machine->spi.open(0, 10*1000*1000, 0);
     
     /* Init nrf24 */
-    if ((res = nRF24_init(_spi2, &config)) != NRF24_OK){
+    if ((res = nRF24_init(&radio, _spi2, &config)) != NRF24_OK){
         printf("[main] - nRF24_init failed. \r\n");
         for (;;) {
             /* Loop forever.. */
@@ -37,7 +58,7 @@ int main(){
     }
 
     /* Check if Chip is connected.  */
-    if (nRF24_isConnected(&isConnected) != NRF24_OK){
+    if (nRF24_isConnected(radio, &isConnected) != NRF24_OK){
         printf("[main] - Could't .isConnected. \r\n");
     }
     else if (!isConnected){
@@ -49,31 +70,39 @@ int main(){
         }
     }
 
-    /* Demo - Set other configurations */
-    (void)nRF24_setDataRate(NRF24_1MBPS);
-    (void)nRF24_setAddressWidth(5u);
-    (void)nRF24_setPALevel(NRF24_PA_MIN, true);
-    (void)nRF24_setAutoAck(false);
-    (void)nRF24_setCrcLength(NRF24_CRC_8);
-
-    (void)nRF24_setChannel(100u);
-    (void)nRF24_setPayloadSize(32u);
+    /* Demo - Set other configurations, only the registers that changed are written. */
+    config.datarate      = NRF24_1MBPS;
+    config.addressWidth  = 5u;
+    config.PA.level      = NRF24_PA_MIN;
+    config.PA.lnaEnabled = true;
+    config.ack.autoAck   = false;
+    config.crc           = NRF24_CRC_8;
+    config.channel       = 100u;
+    config.payloadSize   = 32u;
+    (void)nRF24_applyConfig(radio, &config);
 
     /* Open writing and reading pipes. */
-    (void)nRF24_openWritingPipe(address[!isMaster]);
-    (void)nRF24_stopListening();
+    (void)nRF24_openWritingPipe(radio, address[!isMaster]);
+    (void)nRF24_stopListening(radio);
     
-    (void)nRF24_openReadingPipe(1, (const uint8_t *)address[isMaster]);
+    (void)nRF24_openReadingPipe(radio, 1, (const uint8_t *)address[isMaster]);
     
-    (void)nRF24_startListening(); 
-    (void)nRF24_flushRx();
+    /* Edges of the IRQ pin are queued by the kernel, no polling of spidev. */
+    (void)nRF24_onEvent(radio, NRF24_RX_DR, onReceive, NULL);
+    if (nRF24_attachIrq(radio, IRQ_PIN, NULL, NULL) != NRF24_OK){
+        printf("[main] - Could not attach the IRQ pin. \r\n");
+        return 1;
+    }
+
+    (void)nRF24_startListening(radio); 
+    (void)nRF24_flushRx(radio);
 
     while (true) {
 
-        /* Check if packets are avalible, and read them. */
-        if (nRF24_available()){
-            nRF24_read(&buffer, 32u);
-            totalBytes += 32u; 
+        /* Sleep until the IRQ pin falls, at most until the next stats print. In an existing 
+            epoll loop, add the fd of nRF24_getEventFd and call nRF24_waitEvent(radio, 0) instead. */
+        if (nRF24_waitEvent(radio, 1000u) == NRF24_OK){
+            (void)nRF24_update(radio);
         }
 
         /* Print the received bytes/second every second. */
@@ -83,6 +112,25 @@ int main(){
             
             printf("[Stats] Data rate: %lu bytes/s (total: %lu)\r\n", (unsigned long)diff, (unsigned long)totalBytes);
 
+            /* Counted by the driver, from status bytes it reads anyway. */
+            (void)nRF24_getStats(radio, &stats);
+            printf("[Stats] Pipe 1: %lu payloads, RX FIFO full: %lu, SPI: %lu transactions\r\n", 
+                (unsigned long)stats.rx_payloads[1], (unsigned long)stats.rx_full, (unsigned long)stats.spi_transactions);
+
+            /* With NRF24_LATENCY: the SPI ioctl alone vs the whole transaction (including the CSN GPIO writes). */
+            if ((nRF24_getHistogram(radio, NRF24_LAT_SPI, &spiTime) == NRF24_OK) &&
+                (nRF24_getHistogram(radio, NRF24_LAT_TRANSACTION, &transactionTime) == NRF24_OK)){
+                (void)nRF24_histogramPercentile(&spiTime, 50u, &p50);
+                (void)nRF24_histogramPercentile(&spiTime, 99u, &p99);
+                printf("[Stats] SPI transfer p50 <= %lu us, p99 <= %lu us, max %lu us\r\n", 
+                    (unsigned long)p50, (unsigned long)p99, (unsigned long)spiTime.max);
+
+                (void)nRF24_histogramPercentile(&transactionTime, 50u, &p50);
+                (void)nRF24_histogramPercentile(&transactionTime, 99u, &p99);
+                printf("[Stats] Transaction  p50 <= %lu us, p99 <= %lu us, max %lu us\r\n", 
+                    (unsigned long)p50, (unsigned long)p99, (unsigned long)transactionTime.max);
+            }
+
             lastShown = machine->time.millis();
         }
     }
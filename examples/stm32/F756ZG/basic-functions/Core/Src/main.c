@@ -89,10 +89,12 @@ nrf24_cfg_t config = NRF24_DEFAULT_CFG((uint8_t)STM_GPIO_ENCODE(1, 8), (uint8_t)
 
 extern const machine_t *machine; 
 static spi_handle_t *_spi1;  
+static nrf24_t      *radio;
 
 uint32_t lastShown = 0;
 uint32_t totalBytes = 0;
 uint32_t lastBytes = 0;
+nrf24_stats_t stats;
 
 
 
@@ -136,39 +138,39 @@ int main(void)
   nRF24_halInit(&machine);
   
   _spi1 = machine->spi.open(0, 10, 0);
-  nrf24_status_t a = nRF24_init(_spi1, &config);
+  nrf24_status_t a = nRF24_init(&radio, _spi1, &config);
   
   printf("init retured: %d\r\n", a);
   
-  uint8_t *buffer = (uint8_t *)malloc(32); 
+  static uint8_t buffer[32u]; 
   /* USER CODE END 2 */
 
   /* Infinite loop */
   /* USER CODE BEGIN WHILE */
-  nRF24_setDataRate(NRF24_1MBPS);
-  nRF24_setAddressWidth(5u);
-  nRF24_setPALevel(NRF24_PA_MIN, true);
-  nRF24_setAutoAck(false);
-
-  nRF24_setCrcLength(NRF24_CRC_8);
-  
-  nRF24_setChannel(100u);
-  nRF24_setPayloadSize(32u);
-
-  nRF24_openWritingPipe(address[!false]);
-  nRF24_stopListening();
-
-  nRF24_openReadingPipe(1, (const uint8_t *)address[false]);
-  nRF24_startListening(); 
-  nRF24_flushRx();
+  config.datarate      = NRF24_1MBPS;
+  config.addressWidth  = 5u;
+  config.PA.level      = NRF24_PA_MIN;
+  config.PA.lnaEnabled = true;
+  config.ack.autoAck   = false;
+  config.crc           = NRF24_CRC_8;
+  config.channel       = 100u;
+  config.payloadSize   = 32u;
+  nRF24_applyConfig(radio, &config);
+
+  nRF24_openWritingPipe(radio, address[!false]);
+  nRF24_stopListening(radio);
+
+  nRF24_openReadingPipe(radio, 1, (const uint8_t *)address[false]);
+  nRF24_startListening(radio); 
+  nRF24_flushRx(radio);
 
   while (1) {
     /* USER CODE END WHILE */
 
     /* USER CODE BEGIN 3 */
 
-    if (nRF24_available()){
-      nRF24_read(buffer, 32);
+    if (nRF24_available(radio)){
+      nRF24_read(radio, buffer, 32);
       totalBytes += 32u; 
     }
 
@@ -177,6 +179,10 @@ int main(void)
       lastBytes = totalBytes;
 
       printf("[Stats] Data rate: %lu bytes/s (total: %lu)\r\n", (unsigned long)diff, (unsigned long)totalBytes);
+
+      (void)nRF24_getStats(radio, &stats);
+      printf("[Stats] Pipe 1: %lu payloads, RX FIFO full: %lu\r\n", (unsigned long)stats.rx_payloads[1], 
+        (unsigned long)stats.rx_full);
       
       lastShown = machine->time.millis();
     }
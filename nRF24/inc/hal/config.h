@@ -25,10 +25,65 @@
 #endif 
 
 /**
- * @brief Toggle debug mode, this will print all read/write spi transactions.
+ * @brief Number of radios that can be open at the same time. The driver and the 
+ *  SPI HAL keep their state in static pools of this size, so no heap is used. 
+ */
+#ifndef NRF24_MAX_INSTANCES
+#define NRF24_MAX_INSTANCES (2u)
+#endif
+
+/**
+ * @brief Cache line size (bytes), the indices of nrf24_ring_t are aligned to it so the 
+ *  producer and consumer never write to the same line. 
+ */
+#ifndef NRF24_CACHE_LINE
+#define NRF24_CACHE_LINE (64u)
+#endif
+
+/**
+ * @brief Register writes a radio queues for one machine->spi.batch call (mode switches, 
+ *  nRF24_applyConfig). Costs 2 * 6 bytes and a spi_segment_t per entry. 
+ */
+#ifndef NRF24_BATCH_DEPTH
+#define NRF24_BATCH_DEPTH (16u)
+#endif
+
+/**
+ * @brief Record every SPI transaction in a per radio binary trace ring, see nRF24_traceDump.
+ *  Costs one timestamp and 8 bytes per transaction instead of a printf.
+ * 
+ */
+// #define NRF24_TRACE
+
+/**
+ * @brief Entries kept per radio with NRF24_TRACE, a power of 2. 
+ */
+#ifndef NRF24_TRACE_DEPTH
+#define NRF24_TRACE_DEPTH (64u)
+#endif
+
+/* The ring index is masked with NRF24_TRACE_DEPTH - 1. */
+#ifdef __cplusplus
+static_assert((NRF24_TRACE_DEPTH > 0u) && ((NRF24_TRACE_DEPTH & (NRF24_TRACE_DEPTH - 1u)) == 0u),
+              "NRF24_TRACE_DEPTH must be a power of 2");
+#else
+_Static_assert((NRF24_TRACE_DEPTH > 0u) && ((NRF24_TRACE_DEPTH & (NRF24_TRACE_DEPTH - 1u)) == 0u),
+               "NRF24_TRACE_DEPTH must be a power of 2");
+#endif
+
+/**
+ * @brief Keep log bucketed latency histograms per radio, see nRF24_getHistogram. 
+ *  Adds two machine->time.micros calls to every SPI transaction.
+ * 
+ */
+// #define NRF24_LATENCY
+
+/**
+ * @brief STM32: the application defines HAL_GPIO_EXTI_Callback (other EXTI lines in use) 
+ *  and calls nRF24_stm32ExtiDispatch from it, instead of the one of the library. 
  * 
  */
-// #define NRF24_DEBUG
+// #define NRF24_STM32_USER_EXTI_CALLBACK
 
 
 #endif 
@@ -10,8 +10,16 @@ extern "C" {
 #endif
 
 typedef struct spi_handle spi_handle_t;
+
+/* One segment of a vectored transfer, tx or rx may be NULL (not both). */
+typedef struct {
+    const uint8_t *tx;
+    uint8_t       *rx;
+    size_t         len;
+} spi_segment_t;
+
 typedef struct {
-    // @brief Malloc and start the bus
+    // @brief Claim a handle (static pool of NRF24_MAX_INSTANCES) and start the bus
     spi_handle_t* (*open)(uint8_t bus, uint32_t freq_hz, uint8_t mode);
     
     // @brief 
@@ -24,10 +32,22 @@ typedef struct {
     int (*read)(spi_handle_t *h, uint8_t *data, size_t len);
     // @brief Transfer and receive n bytes 
     int (*transfer)(spi_handle_t *h, const uint8_t *tx, uint8_t *rx, size_t len);
-    // @brief Close and free the bus. 
+    // @brief Transfer n segments back to back as one transfer (CS kept active). Optional, may be NULL. 
+    int (*transferv)(spi_handle_t *h, const spi_segment_t *segments, size_t count);
+    // @brief Close the bus and release the handle. 
     void (*close)(spi_handle_t *h);
+    // @brief Let the SPI peripheral assert chip select (pin, active low) around every transfer(v), the lib 
+    //  then never writes the CSN GPIO. Optional, may be NULL. Returns 0 when the backend took it over. 
+    int (*chipSelect)(spi_handle_t *h, uint8_t pin);
+    // @brief Transfer count segments, every one a transaction of its own (CS released in between). Only used 
+    //  when the backend owns chip select, see chipSelect. Optional, may be NULL. 
+    int (*batch)(spi_handle_t *h, const spi_segment_t *transactions, size_t count);
 } HAL_SPI_t;
 
+/* A CSN pin (nrf24_cfg_t.gpio.csn) wired to the chip select output of the SPI device itself: 
+    the C of /dev/spidevB.C, or the hardware NSS pin of the STM32 SPI. See HAL_SPI_t.chipSelect. */
+#define SPI_HW_CS (0xFFu)
+
 
 #define LOW (uint8_t)0u
 #define HIGH (uint8_t)1u
@@ -36,6 +56,15 @@ typedef struct {
     int (*config)(uint8_t pin, bool output);
     int (*write)(uint8_t pin, bool level);
     bool (*read)(uint8_t pin);
+    // @brief Call callback(arg) from the ISR on a falling edge of pin. Optional, may be NULL. 
+    int (*attachInterrupt)(uint8_t pin, void (*callback)(void *arg), void *arg);
+    int (*detachInterrupt)(uint8_t pin);
+    // @brief For backends without ISRs (Linux): block until an edge of an attached pin, which runs its callback 
+    //  in the calling thread. Returns 1 after an edge, 0 on timeout. Optional, may be NULL. 
+    int (*waitInterrupt)(uint8_t pin, uint32_t timeout_ms);
+    // @brief A file descriptor (poll/epoll) that is readable while an edge of an attached pin waits for 
+    //  waitInterrupt. Optional, may be NULL. 
+    int (*interruptFd)(uint8_t pin);
 } HAL_GPIO_t;
 
 typedef struct {
@@ -45,6 +74,8 @@ typedef struct {
 
 typedef struct {
     uint32_t(*millis)(void);
+    // @brief Free running microsecond counter, wraps at 2^32. 
+    uint32_t(*micros)(void);
 } HAL_Time_t; 
 
 typedef struct {
@@ -58,6 +89,19 @@ extern const machine_t *machine;
 
 extern void nRF24_halInit(const machine_t **machine);
 
+/**
+ * @brief STM32 only, runs the handler machine->gpio.attachInterrupt registered for the 
+ *  EXTI line of GPIO_Pin. With NRF24_STM32_USER_EXTI_CALLBACK the application owns 
+ *  HAL_GPIO_EXTI_Callback and chains to the driver from it. 
+ * 
+ * @example
+ *  void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin){
+ *      nRF24_stm32ExtiDispatch(GPIO_Pin);
+ *      if (GPIO_Pin == BUTTON_Pin) { ... }
+ *  }
+ */
+extern void nRF24_stm32ExtiDispatch(uint16_t GPIO_Pin);
+
 #ifdef __cplusplus
 }
 #endif
@@ -24,12 +24,21 @@ extern "C" {
 #define NRF24_MAX_ADDRESS_WIDTH 5u 
 #define NRF24_MIN_ADDRESS_WIDTH 3u 
 
+/* Max time (ms) to wait for a free TX FIFO slot. */
+#define NRF24_TX_TIMEOUT_MS 95u
+
+/* Tpd2stby (us), power down to standby. Up to 5 ms per the 1.0 datasheet. */
+#define NRF24_TPD2STBY_US 5000u
+/* Tstby2a (us), standby to RX/TX (PLL settle). */
+#define NRF24_TSTBY2A_US  130u
+
 
 typedef enum {
     NRF24_OK, 
     NRF24_ERROR, 
     NRF24_NULL_POINTER,
-    NRF24_ARG_INVALID
+    NRF24_ARG_INVALID,
+    NRF24_TIMEOUT
 } nrf24_status_t; 
 
 
@@ -154,6 +163,19 @@ typedef enum
 } nrf24_irq_flags_t;
 
 
+/* Power/mode state of a radio, see nRF24_getState. */
+typedef enum {
+    NRF24_STATE_POWER_DOWN,
+    // @brief PWR_UP is set, CE must stay low until the ready time (Tpd2stby). 
+    NRF24_STATE_POWERING_UP,
+    // @brief Standby-I (CE low). A pending ready time is a RX to TX turnaround. 
+    NRF24_STATE_STANDBY,
+    // @brief CE high in RX mode, the PLL settles until the ready time (Tstby2a). 
+    NRF24_STATE_RX_SETTLING,
+    NRF24_STATE_RX,
+    NRF24_STATE_TX,
+} nrf24_state_t;
+
 typedef struct {
     uint8_t addressWidth;
     uint8_t payloadSize; 
@@ -184,6 +206,108 @@ typedef struct {
     } gpio;
 } nrf24_cfg_t;
 
+/* A single payload drained from the RX FIFO, see nRF24_readBurst. */
+typedef struct {
+    uint8_t  pipe;
+    uint8_t  length;
+    // @brief machine->time.micros when the payload was read from the chip. 
+    uint32_t timestamp;
+    uint8_t  data[NRF24_MAX_PAYLOAD_SIZE];
+} nrf24_rx_frame_t;
+
+/* A single payload for nRF24_writeBatch. */
+typedef struct {
+    const void *buffer;
+    uint8_t     length;
+    bool        multicast;
+} nrf24_tx_msg_t;
+
+/* The outcome of a single nRF24_writeBatch payload. */
+typedef struct {
+    nrf24_status_t status;
+    // @brief MAX_RT rounds this payload hit. 
+    uint8_t        attempts;
+    // @brief Retransmits from ARC_CNT, every MAX_RT round plus the acked round as far as it was seen (a lower bound). 
+    uint16_t       retransmits;
+} nrf24_tx_result_t;
+
+/**
+ * @brief Link statistics, see nRF24_getStats. The counters wrap. 
+ * 
+ * They are taken from status bytes and registers the driver reads anyway: TX_DS and MAX_RT 
+ *  are counted when STATUS is cleared, the pipe of a payload from the status byte of 
+ *  R_RX_PAYLOAD. OBSERVE_TX is read by the blocking senders and on MAX_RT only. 
+ */
+typedef struct {
+    // @brief Payloads loaded for sending. 
+    uint32_t tx_payloads;
+    // @brief TX_DS events. When streaming without clearing STATUS, one event covers many payloads. 
+    uint32_t tx_ok;
+    // @brief MAX_RT events, payloads that ran out of retries. 
+    uint32_t tx_max_rt;
+    // @brief Retransmits, ARC_CNT of acked payloads (blocking senders) plus a full round per MAX_RT. 
+    uint32_t retransmits;
+    // @brief Lost packets, accumulated from PLOS_CNT. 
+    uint32_t lost;
+    // @brief Payloads read, per pipe. 
+    uint32_t rx_payloads[6u];
+    // @brief Times a FIFO_STATUS read found the RX FIFO full (3 payloads) after it was not, payloads arriving then are dropped by the chip. 
+    uint32_t rx_full;
+    uint32_t flush_rx;
+    uint32_t flush_tx;
+    // @brief CSN low to high cycles. 
+    uint32_t spi_transactions;
+    uint32_t spi_bytes;
+} nrf24_stats_t;
+
+/* What a latency histogram times, see nRF24_getHistogram. */
+typedef enum {
+    NRF24_LAT_SPI = 0u,       // A single machine->spi.transfer(v). 
+    NRF24_LAT_TRANSACTION,    // CSN low to CSN high, the SPI transfer plus the CSN GPIO writes. 
+    NRF24_LAT_TX,             // Payload loaded (nRF24_write, fastWrite, writeWithAck) to its TX_DS cleared. 
+    NRF24_LAT_IRQ,            // IRQ edge to the first payload read after it. 
+    NRF24_LAT_TURNAROUND,     // Payload read to the next payload loaded, e.g. a request to its response. 
+    NRF24_LAT_COUNT
+} nrf24_latency_t;
+
+/* Bucket 0 holds 0 us, bucket i (1..) holds 2^(i-1) .. 2^i - 1 us. The last one everything above. */
+#define NRF24_HIST_BUCKETS (24u)
+
+typedef struct {
+    uint32_t buckets[NRF24_HIST_BUCKETS];
+    uint32_t count;
+    // @brief The longest sample (us). 
+    uint32_t max;
+} nrf24_histogram_t;
+
+/* A single register write of a precomputed register image, see nRF24_initImage. */
+typedef struct {
+    uint8_t reg;
+    uint8_t value;
+} nrf24_reg_write_t;
+
+/* What a nrf24_trace_entry_t records, see nRF24_traceRead. */
+typedef enum {
+    NRF24_TRACE_READ = 0u,  // reg: register, value: the value read 
+    NRF24_TRACE_WRITE,      // reg: register, value: the value written 
+    NRF24_TRACE_READ_NB,    // reg: register or command (FLUSH_RX, R_RX_PL_WID, ..), value: first byte read 
+    NRF24_TRACE_WRITE_NB,   // reg: register or command (ACTIVATE, ..), value: first byte written 
+    NRF24_TRACE_TX_PAYLOAD, // reg: W_TX_PAYLOAD(_NO_ACK) or W_ACK_PAYLOAD | pipe, value: length 
+    NRF24_TRACE_RX_PAYLOAD, // reg: R_RX_PAYLOAD, value: length 
+    NRF24_TRACE_CE,         // value: the new CE level 
+    NRF24_TRACE_ERROR,      // reg: the nrf24_status_t returned, the trace is frozen after it 
+} nrf24_trace_op_t;
+
+/* A single trace entry, status is the STATUS byte clocked out by the transaction. */
+typedef struct {
+    // @brief machine->time.micros at the end of the transaction. 
+    uint32_t timestamp;
+    uint8_t  op;
+    uint8_t  reg;
+    uint8_t  value;
+    uint8_t  status;
+} nrf24_trace_entry_t;
+
 #define NRF24_DEFAULT_CFG(_csn, _ce) { \
     .addressWidth = NRF24_MAX_ADDRESS_WIDTH, \
     .payloadSize = NRF24_MAX_PAYLOAD_SIZE, \
@@ -197,45 +321,89 @@ typedef struct {
     .gpio = { .csn = _csn, .ce = _ce } \
 }
 
-extern nrf24_status_t nRF24_init(spi_handle_t *spi, const nrf24_cfg_t *cfg);
-extern nrf24_status_t nRF24_isConnected(bool *connected);
-extern bool           nRF24_available(void);
-
-extern nrf24_status_t nRF24_powerDown(void);
-extern nrf24_status_t nRF24_powerUp(void);
-
-extern nrf24_status_t nRF24_setChannel(uint8_t channel);
-extern nrf24_status_t nRF24_setAddressWidth(uint8_t size);
-extern nrf24_status_t nRF24_setPayloadSize(uint8_t size);
-extern nrf24_status_t nRF24_setRetries(uint8_t delay, uint8_t count);
-extern nrf24_status_t nRF24_setPALevel(nrf24_pa_dbm_t level, bool enableLna);
-extern nrf24_status_t nRF24_setCrcLength(nrf24_crclength_t length);
-extern nrf24_status_t nRF24_setAutoAck(bool enable);
-extern nrf24_status_t nRF24_setAckPayload(bool enable);
-extern nrf24_status_t nRF24_setDynamicPayloadLength(bool enable);
-extern nrf24_status_t nRF24_setDynamicAck(bool enable);
-extern nrf24_status_t nRF24_setDataRate(nrf24_datarate_t rate);
-
-extern nrf24_status_t nRF24_openReadingPipe(uint8_t pipe, const uint8_t *address);
-extern nrf24_status_t nRF24_closeReadingPipe(uint8_t pipe);
-
-extern nrf24_status_t nRF24_openWritingPipe(const uint8_t *address);
-extern nrf24_status_t nRF24_closeWritingPipe(void);
-
-extern nrf24_status_t nRF24_startListening(void);
-extern nrf24_status_t nRF24_stopListening(void); 
-
-extern nrf24_status_t nRF24_read(void *buffer, uint8_t length);
-extern nrf24_status_t nRF24_write(const void *buffer, uint8_t length, const bool multicast);
-extern nrf24_status_t nRF24_fastWrite(const void *buffer, uint8_t length, const bool multicast);
-
-extern nrf24_status_t nRF24_clearStatusFlags();
-extern nrf24_status_t nRF24_getStatusFlags();
-extern nrf24_status_t nRF24_update();
-extern nrf24_status_t nRF24_flushRx();
-extern nrf24_status_t nRF24_flushTx();
-extern nrf24_status_t nRF24_isValid();
-extern nrf24_status_t nRF24_getVariant();
+/* Opaque handle to a single radio, created by nRF24_init. */
+typedef struct nrf24 nrf24_t;
+
+/* Event handler, called from nRF24_update (not from the ISR) for every event it is registered for. */
+typedef void (*nrf24_event_cb_t)(nrf24_t *radio, nrf24_irq_flags_t event, void *arg);
+
+extern nrf24_status_t nRF24_init(nrf24_t **radio, spi_handle_t *spi, const nrf24_cfg_t *cfg);
+extern nrf24_status_t nRF24_initImage(nrf24_t **radio, spi_handle_t *spi, const nrf24_cfg_t *cfg, 
+                                      const nrf24_reg_write_t *image, size_t count);
+extern nrf24_status_t nRF24_deinit(nrf24_t **radio);
+extern nrf24_status_t nRF24_isConnected(nrf24_t *radio, bool *connected);
+extern bool           nRF24_available(nrf24_t *radio);
+extern bool           nRF24_availablePipe(nrf24_t *radio, uint8_t *pipe);
+extern uint8_t        nRF24_getLastStatus(nrf24_t *radio);
+
+extern nrf24_status_t nRF24_powerDown(nrf24_t *radio);
+extern nrf24_status_t nRF24_powerUp(nrf24_t *radio);
+extern nrf24_status_t nRF24_getState(nrf24_t *radio, nrf24_state_t *state, uint32_t *ready_at_us);
+extern bool           nRF24_isReady(nrf24_t *radio);
+
+extern nrf24_status_t nRF24_setChannel(nrf24_t *radio, uint8_t channel);
+extern nrf24_status_t nRF24_setAddressWidth(nrf24_t *radio, uint8_t size);
+extern nrf24_status_t nRF24_setPayloadSize(nrf24_t *radio, uint8_t size);
+extern nrf24_status_t nRF24_setRetries(nrf24_t *radio, uint8_t delay, uint8_t count);
+extern nrf24_status_t nRF24_setPALevel(nrf24_t *radio, nrf24_pa_dbm_t level, bool enableLna);
+extern nrf24_status_t nRF24_setCrcLength(nrf24_t *radio, nrf24_crclength_t length);
+extern nrf24_status_t nRF24_setAutoAck(nrf24_t *radio, bool enable);
+extern nrf24_status_t nRF24_setAckPayload(nrf24_t *radio, bool enable);
+extern nrf24_status_t nRF24_setDynamicPayloadLength(nrf24_t *radio, bool enable);
+extern nrf24_status_t nRF24_setDynamicAck(nrf24_t *radio, bool enable);
+extern nrf24_status_t nRF24_setDataRate(nrf24_t *radio, nrf24_datarate_t rate);
+
+extern nrf24_status_t nRF24_applyConfig(nrf24_t *radio, const nrf24_cfg_t *cfg);
+extern nrf24_status_t nRF24_syncRegisters(nrf24_t *radio);
+extern nrf24_status_t nRF24_verifyRegisters(nrf24_t *radio, bool *match);
+
+extern nrf24_status_t nRF24_openReadingPipe(nrf24_t *radio, uint8_t pipe, const uint8_t *address);
+extern nrf24_status_t nRF24_closeReadingPipe(nrf24_t *radio, uint8_t pipe);
+
+extern nrf24_status_t nRF24_openWritingPipe(nrf24_t *radio, const uint8_t *address);
+extern nrf24_status_t nRF24_closeWritingPipe(nrf24_t *radio);
+
+extern nrf24_status_t nRF24_startListening(nrf24_t *radio);
+extern nrf24_status_t nRF24_stopListening(nrf24_t *radio); 
+extern nrf24_status_t nRF24_fastStartListening(nrf24_t *radio);
+extern nrf24_status_t nRF24_fastStopListening(nrf24_t *radio);
+
+extern nrf24_status_t nRF24_read(nrf24_t *radio, void *buffer, uint8_t length);
+extern nrf24_status_t nRF24_readPayload(nrf24_t *radio, void *buffer, uint8_t length, uint8_t *received);
+extern nrf24_status_t nRF24_getDynamicPayloadSize(nrf24_t *radio, uint8_t *size);
+extern nrf24_status_t nRF24_readBurst(nrf24_t *radio, nrf24_rx_frame_t *frames, size_t max, size_t *count);
+extern nrf24_status_t nRF24_write(nrf24_t *radio, const void *buffer, uint8_t length, const bool multicast);
+extern nrf24_status_t nRF24_fastWrite(nrf24_t *radio, const void *buffer, uint8_t length, const bool multicast);
+extern nrf24_status_t nRF24_writeWithAck(nrf24_t *radio, const void *buffer, uint8_t length, nrf24_rx_frame_t *ack);
+extern nrf24_status_t nRF24_writeAckPayload(nrf24_t *radio, uint8_t pipe, const void *buffer, uint8_t length);
+extern nrf24_status_t nRF24_writeBatch(nrf24_t *radio, const nrf24_tx_msg_t *msgs, nrf24_tx_result_t *results, 
+                                       size_t count, uint8_t maxAttempts, uint32_t timeout_ms);
+
+extern nrf24_status_t nRF24_acquireBus(nrf24_t *radio);
+extern nrf24_status_t nRF24_releaseBus(nrf24_t *radio);
+extern nrf24_status_t nRF24_clearStatusFlags(nrf24_t *radio, nrf24_irq_flags_t flags);
+extern nrf24_status_t nRF24_getStatusFlags(nrf24_t *radio, nrf24_irq_flags_t *flags);
+extern nrf24_status_t nRF24_attachIrq(nrf24_t *radio, uint8_t pin, void (*notify)(void *arg), void *arg);
+extern nrf24_status_t nRF24_onEvent(nrf24_t *radio, nrf24_irq_flags_t events, nrf24_event_cb_t handler, void *arg);
+extern nrf24_status_t nRF24_update(nrf24_t *radio);
+extern nrf24_status_t nRF24_waitEvent(nrf24_t *radio, uint32_t timeout_ms);
+extern nrf24_status_t nRF24_getEventFd(nrf24_t *radio, int *fd);
+extern nrf24_status_t nRF24_flushRx(nrf24_t *radio);
+extern nrf24_status_t nRF24_flushTx(nrf24_t *radio);
+extern nrf24_status_t nRF24_isValid(nrf24_t *radio);
+
+extern nrf24_status_t nRF24_getStats(nrf24_t *radio, nrf24_stats_t *stats);
+extern nrf24_status_t nRF24_resetStats(nrf24_t *radio);
+
+extern nrf24_status_t nRF24_getHistogram(nrf24_t *radio, nrf24_latency_t which, nrf24_histogram_t *hist);
+extern nrf24_status_t nRF24_resetHistograms(nrf24_t *radio);
+extern nrf24_status_t nRF24_histogramPercentile(const nrf24_histogram_t *hist, uint8_t percent, uint32_t *us);
+
+extern nrf24_status_t nRF24_traceRead(nrf24_t *radio, nrf24_trace_entry_t *entries, size_t max, size_t *count);
+extern nrf24_status_t nRF24_traceFreeze(nrf24_t *radio);
+extern nrf24_status_t nRF24_traceClear(nrf24_t *radio);
+extern nrf24_status_t nRF24_traceDump(nrf24_t *radio);
+extern nrf24_status_t nRF24_getVariant(nrf24_t *radio);
 
 #ifdef __cplusplus
 };
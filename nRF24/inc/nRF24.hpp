@@ -0,0 +1,328 @@
+#ifndef NRF24_HPP
+#define NRF24_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#if (__cplusplus >= 202002L)
+#include <span>
+#endif
+
+#include "inc/nRF24L01.h"
+#include "inc/nRF24.h"
+
+/**
+ * @brief Header only C++17 layer on top of the C driver, for configurations that are known at compile time.
+ *  nRF24::Device (C++20) adds RAII ownership and a std::span payload API.
+ *
+ * The configuration is a type, every register value it needs is computed and checked by the
+ *  compiler, so nRF24_initImage only has to commit a fixed list of register writes. Combinations
+ *  that the C setters silently correct (ackPayloads without dynamicPayloads, ..) do not compile.
+ *
+ * @example
+ *  struct Link : nRF24::Config {
+ *      static constexpr uint8_t csn     = 5u;
+ *      static constexpr uint8_t ce      = 17u;
+ *      static constexpr uint8_t channel = 90u;
+ *  };
+ *
+ *  nRF24::Radio<Link> radio;
+ *  radio.init(spi);
+ *  nRF24_startListening(radio.handle());
+ */
+namespace nRF24 {
+
+/* The defaults of NRF24_DEFAULT_CFG, derive from this and shadow what differs.
+    csn and ce have no default, a Config without them does not compile.
+ */
+struct Config {
+    static constexpr uint8_t           addressWidth    = NRF24_MAX_ADDRESS_WIDTH;
+    static constexpr uint8_t           payloadSize     = NRF24_MAX_PAYLOAD_SIZE;
+    static constexpr uint8_t           channel         = 76u;
+    static constexpr nrf24_datarate_t  datarate        = NRF24_1MBPS;
+    static constexpr nrf24_crclength_t crc             = NRF24_CRC_16;
+    static constexpr bool              dynamicPayloads = false;
+    static constexpr uint8_t           retryDelay      = 5u;
+    static constexpr uint8_t           retryCount      = 15u;
+    static constexpr bool              dynamicAck      = false;
+    static constexpr bool              ackPayload      = false;
+    static constexpr bool              autoAck         = true;
+    static constexpr nrf24_pa_dbm_t    paLevel         = NRF24_PA_MIN;
+    static constexpr bool              lnaEnabled      = true;
+};
+
+template <typename C>
+class Radio {
+    static_assert((C::addressWidth >= NRF24_MIN_ADDRESS_WIDTH) && (C::addressWidth <= NRF24_MAX_ADDRESS_WIDTH),
+                  "addressWidth must be 3, 4 or 5 bytes");
+    static_assert(C::payloadSize <= NRF24_MAX_PAYLOAD_SIZE, "payloadSize is at most 32 bytes");
+    static_assert(C::channel <= NRF24_MAX_RF_CHANNEL, "channel is out of range");
+    static_assert(C::datarate < NRF24_MAX_RATE, "invalid datarate");
+    static_assert(C::crc < NRF24_CRC_ERROR, "invalid crc length");
+    static_assert((C::retryDelay <= 15u) && (C::retryCount <= 15u), "retryDelay and retryCount are 4 bit fields");
+    static_assert(C::paLevel < NRF24_PA_ERROR, "invalid paLevel");
+    static_assert(!C::ackPayload || C::dynamicPayloads, "ackPayload requires dynamicPayloads");
+    static_assert(!C::dynamicPayloads || C::autoAck, "dynamicPayloads requires autoAck");
+    static_assert(!C::autoAck || (C::crc != NRF24_CRC_DISABLED), "autoAck forces the CRC on, select NRF24_CRC_8 or NRF24_CRC_16");
+
+    static constexpr uint8_t bits(bool enable, uint8_t mask) {
+        return enable ? mask : 0u;
+    }
+
+    static constexpr uint8_t rateBits() {
+        return (C::datarate == NRF24_250KBPS) ? (uint8_t)_BV(RF_DR_LOW) :
+               (C::datarate == NRF24_2MBPS)   ? (uint8_t)_BV(RF_DR_HIGH) : 0u;
+    }
+
+    static constexpr nrf24_cfg_t makeConfig() {
+        nrf24_cfg_t out{};
+
+        out.addressWidth    = C::addressWidth;
+        out.payloadSize     = C::payloadSize;
+        out.channel         = C::channel;
+        out.datarate        = C::datarate;
+        out.crc             = C::crc;
+        out.dynamicPayloads = C::dynamicPayloads;
+        out.retries.delay   = C::retryDelay;
+        out.retries.count   = C::retryCount;
+        out.ack.dynamicAck  = C::dynamicAck;
+        out.ack.ackPayload  = C::ackPayload;
+        out.ack.autoAck     = C::autoAck;
+        out.PA.level        = C::paLevel;
+        out.PA.lnaEnabled   = C::lnaEnabled;
+        out.gpio.csn        = C::csn;
+        out.gpio.ce         = C::ce;
+        return out;
+    }
+
+public:
+    /* Register values, same layout as the datasheet. CONFIG leaves PWR_UP and PRIM_RX to the driver. */
+    static constexpr uint8_t setupAw   = (uint8_t)(C::addressWidth - 2u);
+    static constexpr uint8_t setupRetr = (uint8_t)((C::retryDelay << 4u) | C::retryCount);
+    static constexpr uint8_t rfSetup   = (uint8_t)(rateBits() | (C::paLevel << 1u) | bits(C::lnaEnabled, 1u));
+    static constexpr uint8_t feature   = (uint8_t)(bits(C::dynamicPayloads, _BV(EN_DPL)) |
+                                                   bits(C::ackPayload, _BV(EN_ACK_PAY)) |
+                                                   bits(C::dynamicAck, _BV(EN_DYN_ACK)));
+    static constexpr uint8_t dynpd     = bits(C::dynamicPayloads, 0x3F);
+    static constexpr uint8_t enAa      = bits(C::autoAck, 0x3F);
+    static constexpr uint8_t config    = (uint8_t)(bits(C::crc != NRF24_CRC_DISABLED, _BV(EN_CRC)) |
+                                                   bits(C::crc == NRF24_CRC_16, _BV(CRCO)));
+
+    static constexpr nrf24_cfg_t cfg = makeConfig();
+
+    /* Commit order of the C driver: FEATURE before DYNPD, CONFIG last. */
+    static constexpr std::array<nrf24_reg_write_t, 14u> image = {{
+        {SETUP_AW, setupAw}, {SETUP_RETR, setupRetr}, {RF_CH, C::channel}, {RF_SETUP, rfSetup},
+        {FEATURE, feature}, {DYNPD, dynpd}, {EN_AA, enAa},
+        {RX_PW_P0, C::payloadSize}, {RX_PW_P1, C::payloadSize}, {RX_PW_P2, C::payloadSize},
+        {RX_PW_P3, C::payloadSize}, {RX_PW_P4, C::payloadSize}, {RX_PW_P5, C::payloadSize},
+        {NRF_CONFIG, config}
+    }};
+
+    Radio() = default;
+
+    /* Owns the radio it claimed (not the SPI handle), deinit when it goes out of scope. Move only. */
+    ~Radio() {
+        if (radio_ != nullptr) {
+            (void)nRF24_deinit(&radio_);
+        }
+    }
+
+    Radio(const Radio &) = delete;
+    Radio &operator=(const Radio &) = delete;
+
+    Radio(Radio &&other) noexcept : radio_(std::exchange(other.radio_, nullptr)) {
+    }
+
+    Radio &operator=(Radio &&other) noexcept {
+        if (this != &other) {
+            if (radio_ != nullptr) {
+                (void)nRF24_deinit(&radio_);
+            }
+            radio_ = std::exchange(other.radio_, nullptr);
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Claim a radio and commit the precomputed image, see nRF24_initImage.
+     *
+     * @param spi: Opened by machine->spi.open.
+     * @return nrf24_status_t
+     */
+    nrf24_status_t init(spi_handle_t *spi) {
+        return nRF24_initImage(&radio_, spi, &cfg, image.data(), image.size());
+    }
+
+    nrf24_status_t deinit() {
+        return nRF24_deinit(&radio_);
+    }
+
+    /* The C handle, for everything after init. NULL before init, after deinit and once moved from. */
+    nrf24_t *handle() const {
+        return radio_;
+    }
+
+private:
+    nrf24_t *radio_ = nullptr;
+};
+
+#if (__cplusplus >= 202002L)
+/**
+ * @brief Owns a radio and the SPI handle it runs on, both are released by the destructor. Move only.
+ *
+ * Payloads are passed as std::span, the driver clocks them straight from/into the caller's
+ *  memory (see machine->spi.transferv), so read() returns a view into the storage it was given
+ *  and a payload can be decoded in place. A Device that is not open (or was moved from) returns
+ *  NRF24_ERROR from every call instead of passing NULL to the driver. Requires C++20.
+ *
+ * @example
+ *  nRF24::Device radio;
+ *  radio.open<Link>(0u, 10000000u, 0u);
+ *
+ *  std::array<std::byte, NRF24_MAX_PAYLOAD_SIZE> storage;
+ *  std::span<std::byte> payload;
+ *  if (radio.available() && (radio.read(storage, payload) == NRF24_OK)) { decode(payload); }
+ */
+class Device {
+public:
+    Device() = default;
+
+    ~Device() {
+        close();
+    }
+
+    Device(const Device &) = delete;
+    Device &operator=(const Device &) = delete;
+
+    Device(Device &&other) noexcept
+        : spi_(std::exchange(other.spi_, nullptr)), radio_(std::exchange(other.radio_, nullptr)) {
+    }
+
+    Device &operator=(Device &&other) noexcept {
+        if (this != &other) {
+            close();
+            spi_   = std::exchange(other.spi_, nullptr);
+            radio_ = std::exchange(other.radio_, nullptr);
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Open the SPI bus and init the radio with a runtime configuration, see nRF24_init.
+     *
+     * @param bus, freq_hz, mode: Passed to machine->spi.open.
+     * @return nrf24_status_t: NRF24_ERROR if the bus could not be opened, nothing is held then.
+     */
+    nrf24_status_t open(uint8_t bus, uint32_t freq_hz, uint8_t mode, const nrf24_cfg_t &cfg) {
+        nrf24_status_t status = NRF24_ERROR;
+
+        close();
+        if ((spi_ = machine->spi.open(bus, freq_hz, mode)) != nullptr) {
+            status = nRF24_init(&radio_, spi_, &cfg);
+        }
+        if (status != NRF24_OK) {
+            close();
+        }
+        return status;
+    }
+
+    /* Same, with the compile time register image of Radio<C>. */
+    template <typename C>
+    nrf24_status_t open(uint8_t bus, uint32_t freq_hz, uint8_t mode) {
+        nrf24_status_t status = NRF24_ERROR;
+
+        close();
+        if ((spi_ = machine->spi.open(bus, freq_hz, mode)) != nullptr) {
+            status = nRF24_initImage(&radio_, spi_, &Radio<C>::cfg, Radio<C>::image.data(), Radio<C>::image.size());
+        }
+        if (status != NRF24_OK) {
+            close();
+        }
+        return status;
+    }
+
+    /* Power down and release the radio, then close the SPI handle. Safe to call twice. */
+    void close() {
+        if (radio_ != nullptr) {
+            (void)nRF24_deinit(&radio_);
+        }
+        if (spi_ != nullptr) {
+            machine->spi.close(spi_);
+            spi_ = nullptr;
+        }
+    }
+
+    nrf24_status_t write(std::span<const std::byte> payload, bool multicast = false) {
+        if (radio_ == nullptr) {
+            return NRF24_ERROR;
+        } else if (payload.size() > NRF24_MAX_PAYLOAD_SIZE) {
+            return NRF24_ARG_INVALID;
+        }
+        return nRF24_write(radio_, payload.data(), (uint8_t)payload.size(), multicast);
+    }
+
+    nrf24_status_t fastWrite(std::span<const std::byte> payload, bool multicast = false) {
+        if (radio_ == nullptr) {
+            return NRF24_ERROR;
+        } else if (payload.size() > NRF24_MAX_PAYLOAD_SIZE) {
+            return NRF24_ARG_INVALID;
+        }
+        return nRF24_fastWrite(radio_, payload.data(), (uint8_t)payload.size(), multicast);
+    }
+
+    nrf24_status_t writeAckPayload(uint8_t pipe, std::span<const std::byte> payload) {
+        if (radio_ == nullptr) {
+            return NRF24_ERROR;
+        } else if (payload.size() > NRF24_MAX_PAYLOAD_SIZE) {
+            return NRF24_ARG_INVALID;
+        }
+        return nRF24_writeAckPayload(radio_, pipe, payload.data(), (uint8_t)payload.size());
+    }
+
+    /**
+     * @brief Read the top of the RX FIFO into storage, see nRF24_readPayload.
+     *
+     * @param storage: At most NRF24_MAX_PAYLOAD_SIZE bytes of it are used.
+     * @param payload: The received bytes, a view into storage. Empty on error.
+     * @return nrf24_status_t: NRF24_ERROR when not open.
+     */
+    nrf24_status_t read(std::span<std::byte> storage, std::span<std::byte> &payload) {
+        uint8_t        received = 0u;
+        nrf24_status_t status   = NRF24_ERROR;
+
+        if (radio_ != nullptr) {
+            status = nRF24_readPayload(radio_, storage.data(),
+                                       (uint8_t)std::min<size_t>(storage.size(), NRF24_MAX_PAYLOAD_SIZE), &received);
+        }
+        payload = storage.first(received);
+        return status;
+    }
+
+    /* False when not open. */
+    bool available() const {
+        return (radio_ != nullptr) && nRF24_available(radio_);
+    }
+
+    /* The C handle, for everything that has no wrapper. NULL when not open. */
+    nrf24_t *handle() const {
+        return radio_;
+    }
+
+    /* The SPI handle of machine->spi.open. NULL when not open. */
+    spi_handle_t *spi() const {
+        return spi_;
+    }
+
+private:
+    spi_handle_t *spi_   = nullptr;
+    nrf24_t      *radio_ = nullptr;
+};
+#endif
+
+} // namespace nRF24
+
+#endif
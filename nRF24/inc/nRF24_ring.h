@@ -0,0 +1,78 @@
+#ifndef NRF24_RING_H
+#define NRF24_RING_H
+
+#include "stdint.h"
+#include "stdbool.h"
+#include "stddef.h"
+
+/* C11 atomics, std::atomic from C++ (stdatomic.h and _Alignas are C only). Both have the 
+    size and alignment of the plain type on the supported compilers, so the layout matches. */
+#ifdef __cplusplus
+#include <atomic>
+#define NRF24_ATOMIC(type) std::atomic<type>
+#define NRF24_ALIGNAS(n)   alignas(n)
+#else
+#include "stdatomic.h"
+#define NRF24_ATOMIC(type) _Atomic(type)
+#define NRF24_ALIGNAS(n)   _Alignas(n)
+#endif
+
+#include "inc/hal/config.h"
+#include "inc/nRF24.h"
+
+/**
+ * @brief Lock-free single producer / single consumer ring of RX frames.
+ *
+ * The radio context (the task calling nRF24_update) fills it, the application drains it
+ *  at its own pace, so slow processing no longer backs up into the 3 slot RX FIFO.
+ *  Payloads are read from the chip straight into the slots (nRF24_readBurst).
+ *
+ * ! Exactly one producer and one consumer. When full the newest frames are dropped
+ *  (still read from the chip) and counted, see nRF24_ringDropped.
+ *
+ * @example
+ *  static nrf24_rx_frame_t slots[16u];
+ *  static nrf24_ring_t     ring;
+ *
+ *  nRF24_ringInit(&ring, slots, 16u);
+ *  nRF24_onEvent(radio, NRF24_RX_DR, nRF24_ringRxHandler, &ring);
+ *  ...
+ *  nrf24_rx_frame_t *frame;
+ *  while ((frame = nRF24_ringPeek(&ring)) != NULL) { decode(frame); nRF24_ringRelease(&ring); }
+ */
+typedef struct {
+    /* Read only after nRF24_ringInit. */
+    nrf24_rx_frame_t *slots;
+    size_t            mask;
+
+    /* Producer line. tail_cache is the last tail seen, to not touch the consumer line on every frame. */
+    NRF24_ALIGNAS(NRF24_CACHE_LINE) NRF24_ATOMIC(size_t) head;
+    size_t                          tail_cache;
+    NRF24_ATOMIC(uint_least32_t)    dropped;
+
+    /* Consumer line. */
+    NRF24_ALIGNAS(NRF24_CACHE_LINE) NRF24_ATOMIC(size_t) tail;
+    size_t                          head_cache;
+} nrf24_ring_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern nrf24_status_t nRF24_ringInit(nrf24_ring_t *ring, nrf24_rx_frame_t *slots, size_t depth);
+
+/* Producer side. */
+extern nrf24_status_t nRF24_ringFill(nrf24_t *radio, nrf24_ring_t *ring);
+extern void           nRF24_ringRxHandler(nrf24_t *radio, nrf24_irq_flags_t event, void *arg);
+
+/* Consumer side. */
+extern nrf24_rx_frame_t *nRF24_ringPeek(nrf24_ring_t *ring);
+extern void              nRF24_ringRelease(nrf24_ring_t *ring);
+
+extern size_t   nRF24_ringCount(nrf24_ring_t *ring);
+extern uint32_t nRF24_ringDropped(nrf24_ring_t *ring);
+
+#ifdef __cplusplus
+};
+#endif
+#endif
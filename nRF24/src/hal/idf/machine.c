@@ -10,8 +10,11 @@
 #include "esp_timer.h"
 
 struct spi_handle {
-    spi_device_handle_t dev;
+    spi_device_handle_t           dev;
+    spi_host_device_t             host;
+    spi_device_interface_config_t devcfg;
 };
+static spi_handle_t spi_handles[NRF24_MAX_INSTANCES];
 
 /* Timer used for sub ms delays.. */
 static gptimer_handle_t htimer = NULL;
@@ -50,15 +53,65 @@ static spi_handle_t* spi_open(uint8_t bus, uint32_t freq_hz, uint8_t mode) {
         .queue_size = 1,
     };
 
-    /* Because the spi messages are going to be short. Disable DMA to limit Queue overhead */
-    ESP_ERROR_CHECK(spi_bus_initialize(bus, &buscfg, SPI_DMA_DISABLED));
+    /* Because the spi messages are going to be short. Disable DMA to limit Queue overhead. 
+        ESP_ERR_INVALID_STATE: the bus is already initialized, this is another device on it. */
+    esp_err_t error = spi_bus_initialize(bus, &buscfg, SPI_DMA_DISABLED);
+    if (error != ESP_ERR_INVALID_STATE) {
+        ESP_ERROR_CHECK(error);
+    }
 
-    spi_handle_t *h = malloc(sizeof(spi_handle_t));
+    spi_handle_t *h = NULL;
+    for (size_t i = 0u; (i < NRF24_MAX_INSTANCES) && (h == NULL); ++i) {
+        if (spi_handles[i].dev == NULL) {
+            h = &spi_handles[i];
+        }
+    }
+    if (h == NULL) {
+        return NULL;
+    }
+
+    h->host   = bus;
+    h->devcfg = devcfg;
     ESP_ERROR_CHECK(spi_bus_add_device(bus, &devcfg, &h->dev));
     return h;
 }
 
+static int spi_batch(spi_handle_t *h, const spi_segment_t *transactions, size_t count) {
+    esp_err_t error = ESP_OK;
+
+    /* Only with the CS of the device (spi_chip_select), every transaction toggles it. */
+    for (size_t i = 0u; (i < count) && (error == ESP_OK); ++i) {
+        spi_transaction_t t = { 
+            .length    = transactions[i].len * 8, 
+            .tx_buffer = transactions[i].tx, 
+            .rx_buffer = transactions[i].rx 
+        };
+        error = spi_device_polling_transmit(h->dev, &t);
+    }
+    ESP_ERROR_CHECK(error);
+    return error;
+}
+
+/* Any pin can be the hardware CS through the GPIO matrix, re-add the device with it. */
+static int spi_chip_select(spi_handle_t *h, uint8_t pin) {
+    esp_err_t error = ESP_OK;
+
+    if ((pin == SPI_HW_CS) || !GPIO_IS_VALID_OUTPUT_GPIO(pin)) {
+        return -1;
+    }
+
+    (void)spi_bus_remove_device(h->dev);
+    h->devcfg.spics_io_num = pin;
+    if ((error = spi_bus_add_device(h->host, &h->devcfg, &h->dev)) != ESP_OK) {
+        /* Fall back to the GPIO CSN of the lib. */
+        h->devcfg.spics_io_num = -1;
+        ESP_ERROR_CHECK(spi_bus_add_device(h->host, &h->devcfg, &h->dev));
+    }
+    return error;
+}
+
 static int spi_begin_transaction(spi_handle_t *h){
+    /* Exclusive bus until spi_end_transaction, other devices on the bus wait. Not recursive, the lib nests. */
     esp_err_t error = spi_device_acquire_bus(h->dev, portMAX_DELAY);
     ESP_ERROR_CHECK(error);
     return error;  
@@ -89,10 +142,27 @@ static int spi_transfer(spi_handle_t *h, const uint8_t *tx, uint8_t *rx, size_t
     return error;  
 }
 
+static int spi_transferv(spi_handle_t *h, const spi_segment_t *segments, size_t count) {
+    esp_err_t error = ESP_OK;
+
+    /* Chained transactions, CS is kept active up to the last segment. The bus is acquired in beginTransaction. */
+    for (size_t i = 0u; (i < count) && (error == ESP_OK); ++i) {
+        spi_transaction_t t = { 
+            .flags     = ((i + 1u) < count) ? SPI_TRANS_CS_KEEP_ACTIVE : 0u,
+            .length    = segments[i].len * 8, 
+            .tx_buffer = segments[i].tx, 
+            .rx_buffer = segments[i].rx 
+        };
+        error = spi_device_polling_transmit(h->dev, &t);
+    }
+    ESP_ERROR_CHECK(error);
+    return error;  
+}
+
 static void spi_close(spi_handle_t *h) {
     if (h != NULL) {
         spi_bus_remove_device(h->dev);
-        free(h);
+        h->dev = NULL;
     }
 }
 
@@ -110,6 +180,23 @@ static int gpio_write(uint8_t pin, bool level) {
 static bool gpio_read(uint8_t pin) {
     return (bool)gpio_get_level(pin);
 }
+static int gpio_attach_interrupt(uint8_t pin, void (*callback)(void *arg), void *arg) {
+    /* The ISR service is shared, ESP_ERR_INVALID_STATE means it is already installed. */
+    esp_err_t error = gpio_install_isr_service(0);
+    if ((error != ESP_OK) && (error != ESP_ERR_INVALID_STATE)) {
+        return error;
+    }
+
+    error = gpio_set_intr_type(pin, GPIO_INTR_NEGEDGE);
+    if (error == ESP_OK) {
+        error = gpio_isr_handler_add(pin, callback, arg);
+    }
+    return error;
+}
+static int gpio_detach_interrupt(uint8_t pin) {
+    (void)gpio_set_intr_type(pin, GPIO_INTR_DISABLE);
+    return gpio_isr_handler_remove(pin);
+}
 /* End: Machine->gpio */
 
 /* Begin: Machine->sleep */
@@ -134,6 +221,9 @@ static void sleep_us(uint32_t us) {
 static uint32_t millis(){
     return (uint32_t)(esp_timer_get_time() / 1000L);
 }
+static uint32_t micros(){
+    return (uint32_t)esp_timer_get_time();
+}
 
 // Assembled machine
 static const machine_t idf_machine = {
@@ -144,19 +234,25 @@ static const machine_t idf_machine = {
         .endTransaction   = spi_end_transaction,
         .read       =  spi_read, 
         .transfer   = spi_transfer, 
-        .close      = spi_close 
+        .transferv  = spi_transferv,
+        .close      = spi_close,
+        .chipSelect = spi_chip_select,
+        .batch      = spi_batch
     },
     .gpio  = { 
         .config = gpio_configure, 
         .write  = gpio_write, 
-        .read   = gpio_read 
+        .read   = gpio_read,
+        .attachInterrupt = gpio_attach_interrupt,
+        .detachInterrupt = gpio_detach_interrupt,
     },
     .sleep = { 
         .ms     = sleep_ms,
         .us     = sleep_us,
     },
     .time = {
-        .millis = millis
+        .millis = millis,
+        .micros = micros
     }
 };
 
@@ -10,25 +10,89 @@
 #include "unistd.h"
 #include "fcntl.h"
 #include "time.h"
+#include "pthread.h"
+#include "limits.h"
+#include "poll.h"
 #include "sys/ioctl.h" 
 #include "linux/spi/spidev.h" 
+#include "linux/gpio.h" 
 
 
 /* SPI */
 static const int spi_mode[] = {
     SPI_MODE_0, SPI_MODE_1, SPI_MODE_2, SPI_MODE_3 
 };
-static char device[] = "/dev/spidev0.0";
+
+/* The spidev node of bus B.C (spi.open(bus = B * 10 + C)), override for other naming. */
+#ifndef SPI_DEVICE_PATH
+#define SPI_DEVICE_PATH "/dev/spidev%u.%u"
+#endif
+/* Dead bus time (us) after every transfer, the nRF24 does not need any. */
+#ifndef SPI_DELAY_US
+#define SPI_DELAY_US (0u)
+#endif
+#define SPI_MAX_SEGMENTS (4u)
+#define SPI_MAX_BATCH    (16u)
+
+/* One lock per spidev bus (spidevB.x), shared by all handles on it, so the CSN windows 
+    of the devices on that bus never overlap. Taken by beginTransaction. */
+struct spi_bus_lock {
+    uint8_t         bus;
+    uint8_t         users;
+    pthread_mutex_t mutex;
+};
+static struct spi_bus_lock bus_locks[NRF24_MAX_INSTANCES];
+
+/* xfer is set up once by spi_open (speed, word size, delay), a transfer only fills in the buffers. */
 struct spi_handle {
     int spi_file; 
     bool opened; 
+    struct spi_bus_lock *lock;
+    struct spi_ioc_transfer xfer[SPI_MAX_BATCH];
 };
+static spi_handle_t spi_handles[NRF24_MAX_INSTANCES];
+
+static struct spi_bus_lock *spi_claim_lock(uint8_t bus){
+    struct spi_bus_lock *lock = NULL;
 
-/* GPIO */
+    for (size_t i = 0u; (i < NRF24_MAX_INSTANCES) && (lock == NULL); ++i) {
+        if ((bus_locks[i].users > 0u) && (bus_locks[i].bus == bus)) {
+            lock = &bus_locks[i];
+        }
+    }
+    for (size_t i = 0u; (i < NRF24_MAX_INSTANCES) && (lock == NULL); ++i) {
+        if (bus_locks[i].users == 0u) {
+            lock = &bus_locks[i];
+            lock->bus = bus;
+            (void)pthread_mutex_init(&lock->mutex, NULL);
+        }
+    }
+    lock->users++;
+    return lock;
+}
+
+/* GPIO, lines are requested from the GPIO character device (uAPI v2) once, in gpio_config. 
+    A pin is the global number of the sysfs interface: gpiochip (pin / 32), line (pin % 32). 
+    For a test without hardware, load gpio-sim (or gpio-mockup) and point GPIO_CHIP_PATH at it, 
+    as test/test_gpio_sim.c does. 
+ */
+#ifndef GPIO_CHIP_PATH
+#define GPIO_CHIP_PATH "/dev/gpiochip%u"
+#endif
+#ifndef GPIO_LINES_PER_CHIP
+#define GPIO_LINES_PER_CHIP (32u)
+#endif
 #define MAX_PATH_LENGTH (50u)
-static char o_gpio_path[MAX_PATH_LENGTH]; /* To set the direction of gpio via export */
-static char w_gpio_path[MAX_PATH_LENGTH]; /* To set the gpio pin to 0 or 1 */
-static char r_gpio_path[MAX_PATH_LENGTH]; /* To get the value of the gpio pin */
+
+/* The line request of each pin, indexed by pin. -1 when not requested. */
+static int gpio_lines[256u];
+
+/* Attached falling edge callbacks, run by gpio_wait_interrupt in the waiting thread. */
+static struct {
+    void (*callback)(void *arg);
+    void  *arg;
+} gpio_irqs[256u];
+#define GPIO_MAX_EVENTS (16u)
 
 /* Sleep/millis */
 static long start; /* To keep track of the millis since start. */
@@ -36,18 +100,35 @@ static long start; /* To keep track of the millis since start. */
 
 /* Begin: machine->spi */
 static spi_handle_t* spi_open(uint8_t bus, uint32_t freq_hz, uint8_t mode) {
-    spi_handle_t *h = malloc(sizeof(spi_handle_t));
+    spi_handle_t *h = NULL;
+    char path[MAX_PATH_LENGTH];
+    uint8_t bits = 8;
+
+    for (size_t i = 0u; (i < NRF24_MAX_INSTANCES) && (h == NULL); ++i) {
+        if (!spi_handles[i].opened) {
+            h = &spi_handles[i];
+        }
+    }
+    if (h == NULL) {
+        printf("No free spi handle, raise NRF24_MAX_INSTANCES.. \r\n");
+        return NULL;
+    }
+    if (mode > 3u) {
+        printf("Invalid SPI mode %u.. \r\n", (unsigned)mode);
+        return NULL;
+    }
 
     /* means that bus 11 -> spidev1.1 */
-    device[11] += ( (bus/10) % 10);
-    device[13] += ( (bus) % 10);
+    (void)snprintf(path, sizeof(path), SPI_DEVICE_PATH, (unsigned)(bus / 10u), (unsigned)(bus % 10u));
 
-    if ((h->spi_file = open(device, O_RDWR)) < 0 ){
-        printf("Failed to open.. \r\n");
+    if ((h->spi_file = open(path, O_RDWR)) < 0 ){
+        printf("Failed to open %s.. \r\n", path);
+        return NULL;
     }
 
-    uint8_t bits = 8;
-    if (ioctl(h->spi_file, SPI_IOC_WR_MODE, &spi_mode[mode]) < 0) {
+    /* Mode, word size and clock are set once, the transfers never override them. */
+    uint8_t mode_bits = (uint8_t)spi_mode[mode];
+    if (ioctl(h->spi_file, SPI_IOC_WR_MODE, &mode_bits) < 0) {
         perror("Failed to set SPI mode");
         close(h->spi_file);
         return NULL;
@@ -57,150 +138,243 @@ static spi_handle_t* spi_open(uint8_t bus, uint32_t freq_hz, uint8_t mode) {
         close(h->spi_file);
         return NULL;
     }
+    if (ioctl(h->spi_file, SPI_IOC_WR_MAX_SPEED_HZ, &freq_hz) < 0) {
+        perror("Failed to set SPI speed");
+        close(h->spi_file);
+        return NULL;
+    }
 
+    (void)memset(h->xfer, 0, sizeof(h->xfer));
+    for (size_t i = 0u; i < SPI_MAX_BATCH; ++i) {
+        h->xfer[i].speed_hz      = freq_hz;
+        h->xfer[i].bits_per_word = bits;
+        h->xfer[i].delay_usecs   = SPI_DELAY_US;
+    }
+
+    /* Every handle holds at most one lock, so there is always a free one. */
+    h->lock   = spi_claim_lock(bus / 10u);
+    h->opened = true;
     return h;
 }
 
 static int spi_begin_transmission(spi_handle_t *h){
-    /* Nothing to do, CE and CSN is Handle in lib */
-    return 0; 
+    /* CE and CSN are handled in lib, only arbitrate the bus. */
+    return pthread_mutex_lock(&h->lock->mutex);
 }
 
 static void spi_end_transmission(spi_handle_t *h){
-    /* Nothing to do, CE and CSN is Handle in lib */
+    (void)pthread_mutex_unlock(&h->lock->mutex);
 }
 
-static int spi_transmit(spi_handle_t *h, const uint8_t *data, size_t len) {
-    struct spi_ioc_transfer transfer = {
-        .tx_buf = (unsigned long)data,
-        .rx_buf = (unsigned long)NULL,
-        .len = len,
-        .delay_usecs = 0,
-        .speed_hz = 10*1000*1000,  // SPI speed in Hz
-        .bits_per_word = 8
-    };
+/* Fill in xfer[idx], cs_change releases CS after it (within a message). */
+static void spi_prepare(spi_handle_t *h, size_t idx, const uint8_t *tx, uint8_t *rx, size_t len, bool cs_change) {
+    h->xfer[idx].tx_buf    = (unsigned long)tx;
+    h->xfer[idx].rx_buf    = (unsigned long)rx;
+    h->xfer[idx].len       = (uint32_t)len;
+    h->xfer[idx].cs_change = cs_change;
+}
 
-    if (ioctl(h->spi_file, SPI_IOC_MESSAGE(1), &transfer) < 0) {
+/* Send xfer[0 .. count) as one message, one ioctl. */
+static int spi_message(spi_handle_t *h, size_t count) {
+    if (ioctl(h->spi_file, SPI_IOC_MESSAGE(count), h->xfer) < 0) {
         perror("Failed to perform SPI transfer");
-        close(h->spi_file);
         return -1;
     }
-
     return 1;
 }
 
+static int spi_transmit(spi_handle_t *h, const uint8_t *data, size_t len) {
+    spi_prepare(h, 0u, data, NULL, len, false);
+    return spi_message(h, 1u);
+}
+
 static int spi_receive(spi_handle_t *h, uint8_t *data, size_t len) {
-    struct spi_ioc_transfer transfer = {
-        .tx_buf = (unsigned long)NULL,
-        .rx_buf = (unsigned long)data,
-        .len = len,
-        .delay_usecs = 0,
-        .speed_hz = 10*1000*1000,  // SPI speed in Hz
-        .bits_per_word = 8,
-    };
+    spi_prepare(h, 0u, NULL, data, len, false);
+    return spi_message(h, 1u);
+}
 
-    if (ioctl(h->spi_file, SPI_IOC_MESSAGE(1), &transfer) < 0) {
-        perror("Failed to perform SPI transfer");
-        close(h->spi_file);
+static int spi_transmit_receive(spi_handle_t *h, const uint8_t *tx, uint8_t *rx, size_t len) {
+    spi_prepare(h, 0u, tx, rx, len, false);
+    return spi_message(h, 1u);
+}
+
+static int spi_transfer_vector(spi_handle_t *h, const spi_segment_t *segments, size_t count) {
+    if (count > SPI_MAX_SEGMENTS) {
         return -1;
     }
-    
-    return 1;
+
+    /* One message, CS stays active between the segments (cs_change = 0). */
+    for (size_t i = 0u; i < count; ++i) {
+        spi_prepare(h, i, segments[i].tx, segments[i].rx, segments[i].len, false);
+    }
+    return spi_message(h, count);
 }
 
-static int spi_transmit_receive(spi_handle_t *h, const uint8_t *tx, uint8_t *rx, size_t len) {
-    struct spi_ioc_transfer transfer = {
-        .tx_buf = (unsigned long)tx,
-        .rx_buf = (unsigned long)rx,
-        .len = len,
-        .delay_usecs = 10u,
-        .speed_hz = 10*1000*1000,  // SPI speed in Hz
-        .bits_per_word = 8,
-        .cs_change = false
-    };
+static int spi_batch(spi_handle_t *h, const spi_segment_t *transactions, size_t count) {
+    size_t chunk  = 0u;
+    int    status = 1;
 
-    if (ioctl(h->spi_file, SPI_IOC_MESSAGE(1), &transfer) < 0) {
-        perror("Failed to perform SPI transfer");
-        close(h->spi_file);
-        return -1;
+    /* One message (ioctl) per SPI_MAX_BATCH transactions, cs_change releases CS after each but the last. */
+    for (size_t done = 0u; (done < count) && (status > 0); done += chunk) {
+        chunk = ((count - done) < SPI_MAX_BATCH) ? (count - done) : SPI_MAX_BATCH;
+
+        for (size_t i = 0u; i < chunk; ++i) {
+            spi_prepare(h, i, transactions[done + i].tx, transactions[done + i].rx, 
+                transactions[done + i].len, ((i + 1u) < chunk));
+        }
+        status = spi_message(h, chunk);
     }
-    return 1;
+    return status;
+}
+
+/* spidev always asserts its own chip select (the C of spidevB.C) for every message. */
+static int spi_chip_select(spi_handle_t *h, uint8_t pin) {
+    (void)h;
+    return (pin == SPI_HW_CS) ? 0 : -1;
 }
 
 static void spi_close(spi_handle_t *h) {
     if (h) {
         close(h->spi_file);
-        free(h);
+        h->opened = false;
+
+        if (--h->lock->users == 0u) {
+            (void)pthread_mutex_destroy(&h->lock->mutex);
+        }
+        h->lock = NULL;
     }
 }
 
 // ================= GPIO ==================
-static int gpio_config(uint8_t pin, bool output) {
-    FILE *gpio_export = fopen("/sys/class/gpio/export", "w");
-    if (gpio_export == NULL){
-        printf("Could not open export");
+/* (Re)request the line of pin with flags (GPIO_V2_LINE_FLAG_*). */
+static int gpio_request(uint8_t pin, uint64_t flags) {
+    struct gpio_v2_line_request request;
+    char                        chip_path[MAX_PATH_LENGTH];
+    int                         chip = -1;
+
+    /* Reconfigure, the line is requested again with the new direction. */
+    if (gpio_lines[pin] >= 0){
+        (void)close(gpio_lines[pin]);
+        gpio_lines[pin] = -1;
+    }
+
+    (void)snprintf(chip_path, sizeof(chip_path), GPIO_CHIP_PATH, (unsigned)(pin / GPIO_LINES_PER_CHIP));
+    if ((chip = open(chip_path, O_RDWR | O_CLOEXEC)) < 0){
+        perror("Failed to open gpiochip");
         return -1;
     }
 
-    fprintf(gpio_export, "%d", pin);
-    fclose(gpio_export);
+    (void)memset(&request, 0, sizeof(request));
+    request.offsets[0]   = pin % GPIO_LINES_PER_CHIP;
+    request.num_lines    = 1u;
+    request.config.flags = flags;
+    (void)strncpy(request.consumer, "nRF24", sizeof(request.consumer) - 1u);
 
-    snprintf(o_gpio_path, sizeof(o_gpio_path), "/sys/class/gpio/gpio%d/direction", pin);
-    FILE *gpio_direction = fopen(o_gpio_path, "w");
-    if (gpio_direction == NULL) {
-        perror("Failed to open GPIO direction file");
+    if (ioctl(chip, GPIO_V2_GET_LINE_IOCTL, &request) < 0){
+        perror("Failed to request GPIO line");
+        (void)close(chip);
         return -1;
     }
 
-    if (output == true){
-        fprintf(gpio_direction, "out");
-    }
-    else {
-        fprintf(gpio_direction, "in");
-    }
-    fclose(gpio_direction);
-    
+    /* The line request outlives the chip descriptor. */
+    (void)close(chip);
+    gpio_lines[pin] = request.fd;
     return 0;
 }
 
+static int gpio_config(uint8_t pin, bool output) {
+    return gpio_request(pin, output ? GPIO_V2_LINE_FLAG_OUTPUT : GPIO_V2_LINE_FLAG_INPUT);
+}
+
 static int gpio_write(uint8_t pin, bool level) {
-    snprintf(w_gpio_path, sizeof(w_gpio_path), "/sys/class/gpio/gpio%d/value", pin);
-    FILE *value_file = fopen(w_gpio_path, "w");
-    if (value_file == NULL) {
-        perror("Failed to open GPIO value file");
-        return -1;
-    }   
+    struct gpio_v2_line_values values = {
+        .bits = (level == LOW) ? 0u : 1u,
+        .mask = 1u
+    };
 
-    if (level == LOW){
-        fprintf(value_file, "0");
-    }
-    else{
-        fprintf(value_file, "1");
+    if (ioctl(gpio_lines[pin], GPIO_V2_LINE_SET_VALUES_IOCTL, &values) < 0){
+        perror("Failed to write GPIO line");
+        return -1;
     }
-
-    fclose(value_file);
     return 1;
 }
 
 static bool gpio_read(uint8_t pin) {
-    snprintf(r_gpio_path, sizeof(r_gpio_path), "/sys/class/gpio/gpio%d/value", pin);
-    FILE *value_file = fopen(r_gpio_path, "r");
-    if (value_file == NULL) {
-        perror("Failed to open GPIO value file for reading");
+    struct gpio_v2_line_values values = {
+        .bits = 0u,
+        .mask = 1u
+    };
+
+    if (ioctl(gpio_lines[pin], GPIO_V2_LINE_GET_VALUES_IOCTL, &values) < 0){
+        perror("Failed to read GPIO line");
         return false;
     }
-    char value;
-    if (fread(&value, 1, 1, value_file) != 1) {
-        fclose(value_file);
-        return false;
+    return (values.bits & 1u) != 0u;
+}
+
+/* There is no ISR, the line request queues the edges for gpio_wait_interrupt. */
+static int gpio_attach_interrupt(uint8_t pin, void (*callback)(void *arg), void *arg) {
+    if (gpio_request(pin, GPIO_V2_LINE_FLAG_INPUT | GPIO_V2_LINE_FLAG_EDGE_FALLING) != 0){
+        return -1;
     }
-    fclose(value_file);
-    return (value == '1');
+
+    gpio_irqs[pin].callback = callback;
+    gpio_irqs[pin].arg      = arg;
+    return 0;
+}
+
+static int gpio_detach_interrupt(uint8_t pin) {
+    gpio_irqs[pin].callback = NULL;
+    gpio_irqs[pin].arg      = NULL;
+    return gpio_request(pin, GPIO_V2_LINE_FLAG_INPUT);
+}
+
+static int gpio_wait_interrupt(uint8_t pin, uint32_t timeout_ms) {
+    struct gpio_v2_line_event events[GPIO_MAX_EVENTS];
+    struct pollfd             fds    = { .fd = gpio_lines[pin], .events = POLLIN };
+    ssize_t                   length = 0;
+    int                       ready  = 0;
+
+    if ((gpio_lines[pin] < 0) || (gpio_irqs[pin].callback == NULL)){
+        return -1;
+    }
+
+    /* Past INT_MAX ms waits forever. A signal ends the wait like a timeout. */
+    ready = poll(&fds, 1u, (timeout_ms > (uint32_t)INT_MAX) ? -1 : (int)timeout_ms);
+    if (ready <= 0){
+        return 0;
+    }
+
+    if ((length = read(gpio_lines[pin], events, sizeof(events))) < 0){
+        perror("Failed to read GPIO events");
+        return -1;
+    }
+
+    for (size_t i = 0u; i < ((size_t)length / sizeof(events[0])); ++i){
+        gpio_irqs[pin].callback(gpio_irqs[pin].arg);
+    }
+    return 1;
+}
+
+static int gpio_interrupt_fd(uint8_t pin) {
+    return (gpio_irqs[pin].callback != NULL) ? gpio_lines[pin] : -1;
 }
 
 /* Begin: Machine->sleep  */
 static void sleep_setup(void){
 }
+
+static void gpio_setup(void){
+    static bool done = false;
+
+    /* Only once, lines requested after an earlier nRF24_halInit stay valid. */
+    if (!done){
+        for (size_t i = 0u; i < (sizeof(gpio_lines) / sizeof(gpio_lines[0])); ++i){
+            gpio_lines[i] = -1;
+        }
+        done = true;
+    }
+}
 static void sleep_ms(uint32_t ms) {
     usleep(ms*1000);
 }
@@ -210,10 +384,17 @@ static void sleep_us(uint32_t us){
 /* End: Machine->sleep  */
 
 /* Begin: Machine->time  */
+/* Computed in uint32_t, tv_sec * 1000000 overflows the 32 bit long of the Luckfox (signed, UB) 
+    after 35 minutes of uptime. Unsigned it wraps like the counters of the other HALs. */
 static uint32_t millis(void){
     struct timespec ts; 
     clock_gettime(CLOCK_MONOTONIC, &ts);
-    return (ts.tv_sec * 1000) + (ts.tv_nsec / 1000000);
+    return ((uint32_t)ts.tv_sec * 1000u) + (uint32_t)(ts.tv_nsec / 1000000);
+}
+static uint32_t micros(void){
+    struct timespec ts; 
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint32_t)ts.tv_sec * 1000000u) + (uint32_t)(ts.tv_nsec / 1000);
 }
 /* End: Machine->time */
 
@@ -226,12 +407,19 @@ static machine_t stm32_machine = {
         .endTransaction   = spi_end_transmission,
         .read       =  spi_receive, 
         .transfer   = spi_transmit_receive, 
-        .close      = spi_close 
+        .transferv  = spi_transfer_vector,
+        .close      = spi_close,
+        .chipSelect = spi_chip_select,
+        .batch      = spi_batch
     },
     .gpio  = { 
-        .config = gpio_config, 
-        .write  = gpio_write, 
-        .read   = gpio_read,
+        .config          = gpio_config, 
+        .write           = gpio_write, 
+        .read            = gpio_read,
+        .attachInterrupt = gpio_attach_interrupt,
+        .detachInterrupt = gpio_detach_interrupt,
+        .waitInterrupt   = gpio_wait_interrupt,
+        .interruptFd     = gpio_interrupt_fd,
     },
     .sleep = { 
         .ms     = sleep_ms,
@@ -239,6 +427,7 @@ static machine_t stm32_machine = {
     },
     .time = {
         .millis = millis,
+        .micros = micros,
     }
 };
 
@@ -252,6 +441,7 @@ extern void nRF24_halInit(const machine_t **machine){
     /* Init the Hardware timers.  */
     (void)sleep_setup();
 
+    (void)gpio_setup();
     
     *machine = &stm32_machine;
 
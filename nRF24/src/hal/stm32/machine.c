@@ -23,9 +23,17 @@ static GPIO_TypeDef *gpio_ports[] = {
     GPIOA, GPIOB, GPIOC, GPIOD, GPIOE, GPIOF, GPIOG, GPIOH, GPIOI, GPIOJ, GPIOK
 };
 
+/* EXTI lines are shared by all ports, so one callback per pin number. */
+static struct {
+    void (*callback)(void *arg);
+    void  *arg;
+} exti_handlers[MAX_PINS_PER_PORT];
+
 struct spi_handle {
     SPI_HandleTypeDef *hspi;  // STM32 HAL SPI handle
+    bool               hw_cs; // NSS is driven by the SPI, see spi_chip_select
 };
+static spi_handle_t spi_handles[NRF24_MAX_INSTANCES];
 
 static spi_handle_t* spi_open(uint8_t bus, uint32_t freq_hz, uint8_t mode) {
     (void)bus;  /* Ignore the bus id, must be defined within Inc/main.h */
@@ -33,19 +41,35 @@ static spi_handle_t* spi_open(uint8_t bus, uint32_t freq_hz, uint8_t mode) {
     SPI_HandleTypeDef *hspi = &hspiX;
 
     /* Note: STM32 HAL SPI init must be done via CubeMX or HAL_SPI_Init() */
-    spi_handle_t *h = malloc(sizeof(spi_handle_t));
-    h->hspi = hspi;
+    spi_handle_t *h = NULL;
+    for (size_t i = 0u; (i < NRF24_MAX_INSTANCES) && (h == NULL); ++i) {
+        if (spi_handles[i].hspi == NULL) {
+            h = &spi_handles[i];
+        }
+    }
+    if (h != NULL) {
+        h->hspi = hspi;
+    }
 
     return h;
 }
 
+/* Bus arbitration, empty for bare metal. Override both (e.g. with an RTOS mutex) when 
+    other tasks or devices share hspiX. CE and CSN are handled in lib. */
+__weak void nRF24_spiLock(SPI_HandleTypeDef *hspi){
+    (void)hspi;
+}
+__weak void nRF24_spiUnlock(SPI_HandleTypeDef *hspi){
+    (void)hspi;
+}
+
 static int spi_begin_transmission(spi_handle_t *h){
-    /* Nothing to do, CE and CSN is Handle in lib */
+    nRF24_spiLock(h->hspi);
     return 0; 
 }
 
 static void spi_end_transmission(spi_handle_t *h){
-    /* Nothing to do, CE and CSN is Handle in lib */
+    nRF24_spiUnlock(h->hspi);
 }
 
 static int spi_transmit(spi_handle_t *h, const uint8_t *data, size_t len) {
@@ -60,11 +84,61 @@ static int spi_receive(spi_handle_t *h, uint8_t *data, size_t len) {
 
 static int spi_transmit_receive(spi_handle_t *h, const uint8_t *tx, uint8_t *rx, size_t len) {
     int status = HAL_SPI_TransmitReceive(h->hspi, (uint8_t*)tx, rx, len, 1000);
+
+    /* NSS output follows SPE, the HAL call enabled it. Disable to end the transaction. */
+    if (h->hw_cs) {
+        __HAL_SPI_DISABLE(h->hspi);
+    }
+    return status;
+}
+
+static int spi_transmit_receive_vector(spi_handle_t *h, const spi_segment_t *segments, size_t count) {
+    int status = HAL_OK;
+
+    /* CSN is driven by the lib, so back to back HAL calls stay within one CSN window. */
+    for (size_t i = 0u; (i < count) && (status == HAL_OK); ++i) {
+        if (segments[i].rx == NULL) {
+            status = HAL_SPI_Transmit(h->hspi, (uint8_t*)segments[i].tx, segments[i].len, 1000);
+        } else if (segments[i].tx == NULL) {
+            status = HAL_SPI_Receive(h->hspi, segments[i].rx, segments[i].len, 1000);
+        } else {
+            status = HAL_SPI_TransmitReceive(h->hspi, (uint8_t*)segments[i].tx, segments[i].rx, segments[i].len, 1000);
+        }
+    }
+
+    if (h->hw_cs) {
+        __HAL_SPI_DISABLE(h->hspi);
+    }
+    return status;
+}
+
+/* Only with hardware NSS (spi_chip_select), every transfer ends by releasing it. */
+static int spi_batch(spi_handle_t *h, const spi_segment_t *transactions, size_t count) {
+    int status = HAL_OK;
+
+    for (size_t i = 0u; (i < count) && (status == HAL_OK); ++i) {
+        status = spi_transmit_receive(h, transactions[i].tx, transactions[i].rx, transactions[i].len);
+    }
     return status;
 }
 
+/* Only the NSS pin of hspiX, configured in CubeMX as "Hardware NSS Output Signal" with the NSS 
+    pulse mode disabled. NSS is then low for as long as the SPI is enabled. */
+static int spi_chip_select(spi_handle_t *h, uint8_t pin) {
+    if ((pin != SPI_HW_CS) || (h->hspi->Init.NSS != SPI_NSS_HARD_OUTPUT)) {
+        return -1;
+    }
+
+    __HAL_SPI_DISABLE(h->hspi);
+    h->hw_cs = true;
+    return 0;
+}
+
 static void spi_close(spi_handle_t *h) {
-    if (h) free(h);
+    if (h) {
+        h->hspi  = NULL;
+        h->hw_cs = false;
+    }
 }
 
 // ================= GPIO ==================
@@ -108,6 +182,36 @@ static bool gpio_read(uint8_t pin) {
     return HAL_GPIO_ReadPin(port, 1 << (STM_GPIO_DECODE_PIN(pin) % MAX_PINS_PER_PORT));
 }
 
+static int gpio_attach_interrupt(uint8_t pin, void (*callback)(void *arg), void *arg) {
+    /* The EXTI line (falling edge) and its NVIC entry must be configured with CubeMX. */
+    exti_handlers[STM_GPIO_DECODE_PIN(pin)].callback = callback;
+    exti_handlers[STM_GPIO_DECODE_PIN(pin)].arg      = arg;
+    return 0;
+}
+
+static int gpio_detach_interrupt(uint8_t pin) {
+    exti_handlers[STM_GPIO_DECODE_PIN(pin)].callback = NULL;
+    return 0;
+}
+
+/* Run the handler attached to the EXTI line of GPIO_Pin, if any. Call it from the 
+    HAL_GPIO_EXTI_Callback of the application with NRF24_STM32_USER_EXTI_CALLBACK. */
+void nRF24_stm32ExtiDispatch(uint16_t GPIO_Pin) {
+    for (uint8_t i = 0u; i < MAX_PINS_PER_PORT; ++i) {
+        if ((GPIO_Pin == (1u << i)) && (exti_handlers[i].callback != NULL)) {
+            exti_handlers[i].callback(exti_handlers[i].arg);
+        }
+    }
+}
+
+#ifndef NRF24_STM32_USER_EXTI_CALLBACK
+/* Overrides the weak HAL callback, called from HAL_GPIO_EXTI_IRQHandler. Not weak itself, 
+    between two weak definitions the linker keeps whichever comes first (often the empty one). */
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin) {
+    nRF24_stm32ExtiDispatch(GPIO_Pin);
+}
+#endif
+
 /* Begin: Machine->sleep  */
 static void sleep_setup(void){
     htimxSleepRCCEnable();
@@ -150,6 +254,10 @@ static void sleep_us(uint32_t us){
 static uint32_t millis(void){
     return HAL_GetTick();
 }
+static uint32_t micros(void){
+    /* htimXSleep runs at 1 MHz over the full 32 bit period, see sleep_setup. */
+    return __HAL_TIM_GET_COUNTER(&htimXSleep);
+}
 /* End: Machine->time */
 
 static machine_t stm32_machine = {
@@ -160,12 +268,17 @@ static machine_t stm32_machine = {
         .endTransaction   = spi_end_transmission,
         .read       =  spi_receive, 
         .transfer   = spi_transmit_receive, 
-        .close      = spi_close 
+        .transferv  = spi_transmit_receive_vector,
+        .close      = spi_close,
+        .chipSelect = spi_chip_select,
+        .batch      = spi_batch
     },
     .gpio  = { 
         .config = gpio_config, 
         .write  = gpio_write, 
         .read   = gpio_read,
+        .attachInterrupt = gpio_attach_interrupt,
+        .detachInterrupt = gpio_detach_interrupt,
     },
     .sleep = { 
         .ms     = sleep_ms,
@@ -173,6 +286,7 @@ static machine_t stm32_machine = {
     },
     .time = {
         .millis = millis,
+        .micros = micros,
     }
 };
 
@@ -3,6 +3,7 @@
 #include "stdlib.h"
 #include "string.h"
 #include "stdio.h"
+#include "stdatomic.h"
 
 #include "inc/hal/config.h"
 #include "inc/hal/machine.h"
@@ -11,51 +12,163 @@
 #include "inc/nRF24.h"
 
 /* Private functions */
-static nrf24_status_t _initRadio();
-static nrf24_status_t _beginTransaction();
-static nrf24_status_t _endTransaction();
-static nrf24_status_t _toggleFeatures(void);
+static nrf24_status_t _initRadio(nrf24_t *radio, const nrf24_reg_write_t *image, size_t count);
+static nrf24_status_t _beginTransaction(nrf24_t *radio);
+static nrf24_status_t _endTransaction(nrf24_t *radio);
+static nrf24_status_t _toggleFeatures(nrf24_t *radio);
+
+static nrf24_status_t _readRegister(nrf24_t *radio, uint8_t req, uint8_t *result);
+static nrf24_status_t _readRegisternb(nrf24_t *radio, uint8_t req, uint8_t *buffer, size_t length);
+
+static nrf24_status_t _writeRegister(nrf24_t *radio, uint8_t reg, const uint8_t value);
+static nrf24_status_t _writeRegisternb(nrf24_t *radio, uint8_t reg, const uint8_t* buf, uint8_t length);
+static void _onRegisterWrite(nrf24_t *radio, uint8_t reg, uint8_t value);
+static void _batchWrite(nrf24_t *radio, uint8_t reg, const uint8_t *buffer, uint8_t length);
+static void _batchUpdate(nrf24_t *radio, uint8_t reg, uint8_t value);
+static void _batchSubmit(nrf24_t *radio);
+static uint8_t *_shadowAddress(nrf24_t *radio, uint8_t reg);
+static nrf24_status_t _buildImage(nrf24_t *radio, const nrf24_cfg_t *cfg, uint8_t *image);
+
+static void csn(nrf24_t *radio, bool level);
+static void _setupChipSelect(nrf24_t *radio);
+static void ce(nrf24_t *radio, bool level);
+static void _readyNotBefore(nrf24_t *radio, uint32_t us);
+static void _dataRateConversion(nrf24_t *radio, nrf24_datarate_t rate, uint8_t *bits); 
+static bool _isinTxMode(nrf24_t *radio);
+
+static nrf24_status_t _writePayload(nrf24_t *radio, const void *buffer, uint8_t length, uint8_t command);
+static nrf24_status_t _readPayload(nrf24_t *radio, void *buffer, uint8_t length, uint8_t *received);
+static uint8_t _updateStatus(nrf24_t *radio);
+static uint8_t _observeTx(nrf24_t *radio);
+static void _transfer(nrf24_t *radio, const uint8_t *tx, uint8_t *rx, size_t len);
+static void _transferv(nrf24_t *radio, const spi_segment_t *segments, size_t count);
+static void _onRxPayload(nrf24_t *radio);
+static void _onTxPayload(nrf24_t *radio);
+
+#ifdef NRF24_LATENCY
+static void _latency(nrf24_t *radio, nrf24_latency_t which, uint32_t start);
+#endif
+static uint8_t _countTxQueued(nrf24_t *radio);
+static nrf24_t *_claimRadio(void);
+static void _releaseRadio(nrf24_t *radio);
+static void _irqHandler(void *arg);
+
+#ifdef NRF24_TRACE
+static void _trace(nrf24_t *radio, nrf24_trace_op_t op, uint8_t reg, uint8_t value);
+static void _traceDescribe(const nrf24_trace_entry_t *entry, char *out, size_t size);
+
+/* Record a transaction, compiled out without NRF24_TRACE. */
+#define TRACE(radio, op, reg, value) _trace((radio), (op), (uint8_t)(reg), (uint8_t)(value))
+#else
+#define TRACE(radio, op, reg, value) ((void)0)
+#endif
+
+/* Record the status an operation failed with, this freezes the trace. */
+#define TRACE_ERROR(radio, status) TRACE((radio), NRF24_TRACE_ERROR, (status), 0u)
+
+/* Size of the register map, FEATURE is the last register. */
+#define NRF24_REG_COUNT (FEATURE + 1u)
 
-static nrf24_status_t _readRegister(uint8_t req, uint8_t *result);
-static nrf24_status_t _readRegisternb(uint8_t req, uint8_t *buffer, size_t length);
-
-static nrf24_status_t _writeRegister(uint8_t reg, const uint8_t value);
-static nrf24_status_t _writeRegisternb(uint8_t reg, const uint8_t* buf, uint8_t length);
-
-static void csn(bool level);
-static void ce(bool level);
-static void _dataRateConversion(nrf24_datarate_t rate, uint8_t *bits); 
-static bool _isinTxMode(void);
-
-static nrf24_status_t _writePayload(const void *buffer, uint8_t length, const bool multicast);
-static nrf24_status_t _readPayload(void *buffer, uint8_t length);
-static uint8_t _updateStatus(void);
-
-static spi_handle_t *_spi = NULL; 
-static nrf24_cfg_t  *_cfg  = NULL;
-
-static uint8_t *tx_buffer = NULL;
-static uint8_t *rx_buffer = NULL;
-static bool    _is_p_variant = false; 
+typedef struct {
+    uint8_t num;
+    uint8_t writeAddress[NRF24_MAX_ADDRESS_WIDTH];
+    uint8_t readAddress[NRF24_MAX_ADDRESS_WIDTH]; 
+} nrf24_pipe_t; 
 
-/* For storing the value of the NRF_CONFIG register. 
-    Used for determination the state of the device. 
+/* All the state of a single radio. Nothing in here is shared between instances, 
+    so every radio can be driven from its own thread/task. 
  */
-static uint8_t config_reg = 0u;
-
-static uint8_t nrf24_spi_status = 0u; 
+struct nrf24 {
+    spi_handle_t *spi; 
+    nrf24_cfg_t   cfg; 
+
+    uint8_t tx_buffer[NRF24_MAX_PAYLOAD_SIZE + 1u];
+    uint8_t rx_buffer[NRF24_MAX_PAYLOAD_SIZE + 1u];
+    bool    is_p_variant; 
+
+    /* Shadow of every writable register, kept in sync by _writeRegister(nb). 
+        Setters modify the shadow and write it back, so no read-modify-write 
+        round trips are needed. NRF_CONFIG is also used to determine the state 
+        of the device. 
+     */
+    uint8_t regs[NRF24_REG_COUNT];
+    uint8_t rx_addr[2u][NRF24_MAX_ADDRESS_WIDTH];
+    uint8_t tx_addr[NRF24_MAX_ADDRESS_WIDTH];
+
+    uint8_t spi_status; 
+
+    /* TxDelay (us), RX to TX turnaround that lets the last ACK go out. */
+    uint16_t txDelay;
+    bool     pipe0_is_rx; 
+
+    /* Nesting depth of nRF24_acquireBus, the HAL transaction spans depth 1 -> 0. */
+    uint8_t bus_depth;
+
+    /* The SPI backend asserts CSN itself, see HAL_SPI_t.chipSelect. */
+    bool hw_cs;
+
+    /* Register writes queued by _batchWrite, each a transaction of its own. Sent by _batchSubmit. */
+    uint8_t       batch_tx[NRF24_BATCH_DEPTH][NRF24_MAX_ADDRESS_WIDTH + 1u];
+    uint8_t       batch_rx[NRF24_BATCH_DEPTH][NRF24_MAX_ADDRESS_WIDTH + 1u];
+    spi_segment_t batch[NRF24_BATCH_DEPTH];
+    uint8_t       batch_count;
+
+    /* Power/mode state machine, ready_at (machine->time.micros) ends the current window. 
+        ready_at is only compared while ready_pending, an old one would read as in the future 
+        again once micros has moved on by 2^31 us (~35.8 min). */
+    nrf24_state_t state;
+    uint32_t      ready_at;
+    bool          ready_pending;
+
+    nrf24_pipe_t pipe0_cfg;
+
+    /* Event engine, the ISR only sets irq_pending. nRF24_update does the SPI work. */
+    volatile bool    irq_pending;
+    bool             irq_attached;
+    uint8_t          irq_pin;
+    void           (*irq_notify)(void *arg);
+    void            *irq_arg;
+    nrf24_event_cb_t handlers[3u];
+    void            *handler_args[3u];
+
+    /* Link statistics, plos_seen is the PLOS_CNT already counted in stats.lost. rx_was_full 
+        is RX_FULL of the last FIFO_STATUS read (cleared by reading or flushing a payload), so 
+        stats.rx_full counts the FIFO filling up, not the polls that find it full. */
+    nrf24_stats_t stats;
+    uint8_t       plos_seen;
+    bool          rx_was_full;
+
+#ifdef NRF24_LATENCY
+    /* Start (machine->time.micros) of the intervals in flight, see nrf24_latency_t. */
+    nrf24_histogram_t latency[NRF24_LAT_COUNT];
+    uint32_t          lat_txn_at;
+    uint32_t          lat_tx_at;
+    uint32_t          lat_rx_at;
+    volatile uint32_t lat_irq_at;
+    bool              lat_tx_pending;
+    bool              lat_rx_pending;
+    volatile bool     lat_irq_pending;
+#endif
+
+#ifdef NRF24_TRACE
+    /* Binary trace ring, trace_count wraps at NRF24_TRACE_DEPTH. Frozen by an error. */
+    nrf24_trace_entry_t trace[NRF24_TRACE_DEPTH];
+    uint32_t            trace_count;
+    bool                trace_frozen;
+#endif
+};
 
-/* TxDelay (ms)*/
-static uint16_t txDelay = 0u;
-static bool pipe0_is_rx = false; 
+/* Storage of every radio, the memory use is fixed at link time. */
+static nrf24_t radio_pool[NRF24_MAX_INSTANCES];
 
-typedef struct {
-    uint8_t  num;
-    uint8_t *writeAddress;
-    uint8_t *readAddress; 
-} nrf24_pipe_t; 
+/* Slot i of radio_pool is taken, claimed and released atomically so radios can be 
+    opened and closed from several threads/tasks at once. */
+static atomic_bool radio_claimed[NRF24_MAX_INSTANCES];
 
-static nrf24_pipe_t pipe0_cfg = {.num = 0};
+/* The events in the order nRF24_update dispatches them, indexes handlers[]. */
+static const nrf24_irq_flags_t event_flags[] = {
+    NRF24_RX_DR, NRF24_TX_DS, NRF24_TX_DF
+};
 
 static const uint8_t pipe_reg_address[] = {
     RX_ADDR_P0, RX_ADDR_P1, RX_ADDR_P2,
@@ -67,84 +180,481 @@ static const uint8_t pipe_enn_bits[] = {
     ERX_P3, ERX_P4, ERX_P5
 };
 
-nrf24_status_t nRF24_init(spi_handle_t *spi, const nrf24_cfg_t *cfg){
+/* Filler clocked out next to a payload by the vectored (transferv) path. */
+static const uint8_t blank_bytes[NRF24_MAX_PAYLOAD_SIZE] = {0u};
+
+/* All single byte registers that are writable, and thus shadowed. 
+    The multi byte addresses (RX_ADDR_P0/P1 and TX_ADDR) are handled separately. 
+ */
+static const uint8_t shadow_regs[] = {
+    NRF_CONFIG, EN_AA, EN_RXADDR, SETUP_AW, SETUP_RETR, RF_CH, RF_SETUP,
+    RX_ADDR_P2, RX_ADDR_P3, RX_ADDR_P4, RX_ADDR_P5,
+    RX_PW_P0, RX_PW_P1, RX_PW_P2, RX_PW_P3, RX_PW_P4, RX_PW_P5,
+    DYNPD, FEATURE
+};
+
+static const uint8_t shadow_addr_regs[] = {
+    RX_ADDR_P0, RX_ADDR_P1, TX_ADDR
+};
+
+/* The registers controlled by nrf24_cfg_t, in the order they are committed. 
+    FEATURE goes before DYNPD, as DYNPD requires EN_DPL to be set. 
+ */
+static const uint8_t config_regs[] = {
+    SETUP_AW, SETUP_RETR, RF_CH, RF_SETUP, FEATURE, DYNPD, EN_AA,
+    RX_PW_P0, RX_PW_P1, RX_PW_P2, RX_PW_P3, RX_PW_P4, RX_PW_P5,
+    NRF_CONFIG
+};
+
+nrf24_status_t nRF24_init(nrf24_t **handle, spi_handle_t *spi, const nrf24_cfg_t *cfg){
     nrf24_status_t status = NRF24_OK;
+    nrf24_t       *radio  = NULL; 
 
-    if ((spi == NULL) || (cfg == NULL)) {
+    if ((handle == NULL) || (spi == NULL) || (cfg == NULL)) {
         status = NRF24_NULL_POINTER;
     }
-    else if (_spi != NULL){
+    else if ((radio = _claimRadio()) == NULL){
+        /* All NRF24_MAX_INSTANCES radios are in use. */
         status = NRF24_ERROR; 
     }
     else {
         /* Init the NRF24 */
-        _spi = spi;
-        _cfg = (nrf24_cfg_t *)cfg; 
-        
-        machine->gpio.config(_cfg->gpio.ce, true);
-        machine->gpio.config(_cfg->gpio.csn, true);
+        radio->spi = spi;
+        radio->cfg = *cfg; 
         
-        (void)ce(LOW);
-        /* Let the CE Settle */
-        machine->sleep.ms(5);
-        
-        (void)csn(HIGH);
+        machine->gpio.config(radio->cfg.gpio.ce, true);
+        (void)ce(radio, LOW);
+        (void)_setupChipSelect(radio);
+
+        status = _initRadio(radio, NULL, 0u);
+    }
+
+    if (status == NRF24_OK){
+        *handle = radio; 
+    } else if (radio != NULL) {
+        _releaseRadio(radio);
+    }
+
+    return status; 
+};
+
+/**
+ * @brief nRF24_init with a precomputed register image instead of translating cfg at runtime. 
+ * 
+ * The image is committed as is, only the writes that differ from the chip's (reset) 
+ *  values go over SPI. Used by the C++ layer (inc/nRF24.hpp), which builds and validates 
+ *  the image at compile time. 
+ * 
+ * ! Nothing is validated or corrected here, cfg must describe the same configuration 
+ *  as the image. Use nRF24_init when in doubt. 
+ * 
+ * @param cfg: The configuration the image was built from, used for the runtime paths. 
+ * @param image: Register writes, in the order they are committed. 
+ * @param count: Number of entries in image. 
+ * @return nrf24_status_t 
+ */
+nrf24_status_t nRF24_initImage(nrf24_t **handle, spi_handle_t *spi, const nrf24_cfg_t *cfg, 
+                               const nrf24_reg_write_t *image, size_t count){
+    nrf24_status_t status = NRF24_OK;
+    nrf24_t       *radio  = NULL; 
 
-        tx_buffer = (uint8_t *)malloc(sizeof(uint8_t) * NRF24_MAX_PAYLOAD_SIZE + 1u);
-        rx_buffer = (uint8_t *)malloc(sizeof(uint8_t) * NRF24_MAX_PAYLOAD_SIZE + 1u);
+    if ((handle == NULL) || (spi == NULL) || (cfg == NULL) || (image == NULL)) {
+        status = NRF24_NULL_POINTER;
+    }
+    else if ((radio = _claimRadio()) == NULL){
+        status = NRF24_ERROR; 
+    }
+    else {
+        radio->spi = spi;
+        radio->cfg = *cfg; 
         
-        pipe0_cfg.readAddress =  (uint8_t *)malloc(sizeof(uint8_t) * 5u);
-        pipe0_cfg.writeAddress = (uint8_t *)malloc(sizeof(uint8_t) * 5u);
+        machine->gpio.config(radio->cfg.gpio.ce, true);
+        (void)ce(radio, LOW);
+        (void)_setupChipSelect(radio);
 
-        status = _initRadio();
+        status = _initRadio(radio, image, count);
     }
+
+    if (status == NRF24_OK){
+        *handle = radio; 
+    } else if (radio != NULL) {
+        _releaseRadio(radio);
+    }
+
     return status; 
 };
 
+/**
+ * @brief Power down the radio and release its slot, the handle is set to NULL. 
+ * 
+ * ! The SPI handle is not closed, it is owned by the caller (machine->spi.close). 
+ * 
+ * @param handle: The radio returned by nRF24_init. 
+ * @return nrf24_status_t 
+ */
+nrf24_status_t nRF24_deinit(nrf24_t **handle){
+    nrf24_status_t status = NRF24_OK;
+    nrf24_t       *radio  = NULL;
+
+    if ((handle == NULL) || ((radio = *handle) == NULL)){
+        return NRF24_NULL_POINTER;
+    }
+
+    /* A HAL may attach without being able to detach, the pin is then left to the application. */
+    if (radio->irq_attached && (machine->gpio.detachInterrupt != NULL)){
+        (void)machine->gpio.detachInterrupt(radio->irq_pin);
+    }
+
+    ce(radio, LOW);
+    status = nRF24_powerDown(radio);
+
+    _releaseRadio(radio);
+    *handle = NULL;
+
+    return status;
+};
+
 
-nrf24_status_t nRF24_isConnected(bool *connected) {
+nrf24_status_t nRF24_isConnected(nrf24_t *radio, bool *connected) {
     nrf24_status_t status = NRF24_OK;
     uint8_t        result = 0u; 
 
-    status = _readRegister(SETUP_AW, &result);
+    status = _readRegister(radio, SETUP_AW, &result);
     /* + 2 because the AddressWidth is stored -2 within NRF24 
         See nRF24_setAddressWidth for more info. */
-    *connected = ((result + 2u) == _cfg->addressWidth);
+    *connected = ((result + 2u) == radio->cfg.addressWidth);
 
     return status;
 };
 
-bool nRF24_available(void) {
-    uint8_t result = 0u; 
-    (void)_readRegister(FIFO_STATUS, &result);
+bool nRF24_available(nrf24_t *radio) {
+    return nRF24_availablePipe(radio, NULL);
+};
+
+/**
+ * @brief Check if a payload is waiting, and on which pipe. 
+ * 
+ * Only a single NOP byte is clocked, STATUS holds the pipe number of the payload at the 
+ *  head of the RX FIFO in RX_P_NO (bits 3:1). 0b111 means the RX FIFO is empty. 
+ * 
+ * @param pipe: Optional (NULL), set to the pipe of the next payload if available. 
+ * @return true if a payload is available. 
+ */
+bool nRF24_availablePipe(nrf24_t *radio, uint8_t *pipe) {
+    uint8_t pipe_num = (uint8_t)((_updateStatus(radio) >> RX_P_NO) & 0x07);
+    bool    result   = (pipe_num <= 5u);
+
+    if (result && (pipe != NULL)){
+        *pipe = pipe_num;
+    }
+    return result;
+};
+
+/**
+ * @brief The STATUS byte returned by the last SPI transaction, no SPI traffic.  
+ * 
+ * Every transaction with the chip returns STATUS as first byte, so after e.g. 
+ *  nRF24_read() this tells if more payloads are waiting (RX_P_NO) without polling again.
+ * 
+ * @return uint8_t: The raw STATUS register.
+ */
+uint8_t nRF24_getLastStatus(nrf24_t *radio) {
+    return radio->spi_status;
+};
+
+/**
+ * @brief Read the IRQ flags (RX_DR, TX_DS, MAX_RT) from the STATUS byte. 
+ * 
+ * @param flags: The raised flags, a mask of nrf24_irq_flags_t. 
+ * @return nrf24_status_t 
+ */
+nrf24_status_t nRF24_getStatusFlags(nrf24_t *radio, nrf24_irq_flags_t *flags){
+    if (flags == NULL){
+        return NRF24_NULL_POINTER;
+    }
+
+    *flags = (nrf24_irq_flags_t)(_updateStatus(radio) & NRF24_IRQ_ALL);
+    return NRF24_OK;
+};
+
+/**
+ * @brief Clear IRQ flags, the IRQ pin is released once all raised flags are cleared. 
+ * 
+ * @param flags: The flags to clear, a mask of nrf24_irq_flags_t. 
+ * @return nrf24_status_t 
+ */
+nrf24_status_t nRF24_clearStatusFlags(nrf24_t *radio, nrf24_irq_flags_t flags){
+    return _writeRegister(radio, NRF_STATUS, (uint8_t)(flags & NRF24_IRQ_ALL));
+};
+
+/**
+ * @brief Hold the SPI bus (machine->spi.beginTransaction) until the matching nRF24_releaseBus. 
+ * 
+ * Calls nest, only the outermost pair reaches the HAL. Every driver operation that takes 
+ *  more than one transaction holds the bus for its whole duration, so radios and other 
+ *  devices on the same bus interleave per operation instead of per register. Wrap a 
+ *  sequence of calls to keep it together, e.g. a reconfiguration. 
+ * 
+ * ! Don't hold the bus over waits, nRF24_write and friends wait for the air and do not hold it. 
+ * 
+ * @return nrf24_status_t: NRF24_ERROR if the HAL could not take the bus. 
+ */
+nrf24_status_t nRF24_acquireBus(nrf24_t *radio){
+    if (radio->bus_depth == UINT8_MAX){
+        return NRF24_ERROR;
+    }
+
+    if ((radio->bus_depth == 0u) && (machine->spi.beginTransaction(radio->spi) != 0)){
+        return NRF24_ERROR;
+    }
+
+    radio->bus_depth++;
+    return NRF24_OK;
+};
+
+/**
+ * @brief Release a hold of nRF24_acquireBus, the last one hands the bus back to the HAL. 
+ * 
+ * @return nrf24_status_t: NRF24_ERROR without a matching nRF24_acquireBus. 
+ */
+nrf24_status_t nRF24_releaseBus(nrf24_t *radio){
+    if (radio->bus_depth == 0u){
+        return NRF24_ERROR;
+    }
+
+    if (--radio->bus_depth == 0u){
+        machine->spi.endTransaction(radio->spi);
+    }
+    return NRF24_OK;
+};
+
+/**
+ * @brief Drive nRF24_update from the IRQ pin instead of polling SPI. 
+ * 
+ * On a falling edge the ISR marks the radio pending and calls notify(arg), e.g. to 
+ *  wake the task that calls nRF24_update. Until then nRF24_update returns without any 
+ *  SPI traffic. 
+ * 
+ * ! notify runs in interrupt context, it must not call into the driver. 
+ * 
+ * @param pin: The pin the IRQ of the radio is connected to. 
+ * @param notify: Optional, called from the ISR. 
+ * @param arg: Passed to notify. 
+ * @return nrf24_status_t: NRF24_ERROR if the HAL has no attachInterrupt. 
+ */
+nrf24_status_t nRF24_attachIrq(nrf24_t *radio, uint8_t pin, void (*notify)(void *arg), void *arg){
+    if (machine->gpio.attachInterrupt == NULL){
+        return NRF24_ERROR;
+    }
+
+    radio->irq_pin     = pin;
+    radio->irq_notify  = notify;
+    radio->irq_arg     = arg;
+    radio->irq_pending = true; /* Catch up on flags raised before the edge could be seen. */
+
+    (void)machine->gpio.config(pin, false);
+    if (machine->gpio.attachInterrupt(pin, _irqHandler, radio) != 0){
+        return NRF24_ERROR;
+    }
+
+    radio->irq_attached = true;
+    return NRF24_OK;
+};
+
+/**
+ * @brief Block until the IRQ pin signals an event, or timeout_ms has passed. Run nRF24_update after it. 
+ * 
+ * Needs nRF24_attachIrq. With machine->gpio.waitInterrupt (Linux) the thread sleeps in the kernel 
+ *  until the edge, else the ISR flag is checked every ms. A timeout of 0 only collects the edges 
+ *  that already happened, e.g. once the fd of nRF24_getEventFd is readable. 
+ * 
+ * @example
+ *  while (running) {
+ *      if (nRF24_waitEvent(radio, 1000u) == NRF24_OK) { nRF24_update(radio); }
+ *  }
+ * 
+ * @return nrf24_status_t: NRF24_TIMEOUT when no event came in. 
+ */
+nrf24_status_t nRF24_waitEvent(nrf24_t *radio, uint32_t timeout_ms){
+    uint32_t start = machine->time.millis();
+
+    if (!radio->irq_attached){
+        return NRF24_ERROR;
+    }
+
+    if (machine->gpio.waitInterrupt != NULL){
+        /* Also when already pending, to consume the edges that wait in the fd. */
+        if (machine->gpio.waitInterrupt(radio->irq_pin, radio->irq_pending ? 0u : timeout_ms) < 0){
+            return NRF24_ERROR;
+        }
+    } else {
+        while (!radio->irq_pending && ((machine->time.millis() - start) < timeout_ms)){
+            machine->sleep.ms(1u);
+        }
+    }
+    return radio->irq_pending ? NRF24_OK : NRF24_TIMEOUT;
+};
+
+/**
+ * @brief A file descriptor that is readable when the IRQ pin fell, to add the radio to an 
+ *  existing poll/epoll loop. When it is readable call nRF24_waitEvent(radio, 0) and nRF24_update. 
+ * 
+ * @param fd: The descriptor, owned by the HAL. Do not read or close it. 
+ * @return nrf24_status_t: NRF24_ERROR without nRF24_attachIrq or when the HAL has no such fd. 
+ */
+nrf24_status_t nRF24_getEventFd(nrf24_t *radio, int *fd){
+    if (fd == NULL){
+        return NRF24_NULL_POINTER;
+    }
+
+    if (!radio->irq_attached || (machine->gpio.interruptFd == NULL) || 
+        ((*fd = machine->gpio.interruptFd(radio->irq_pin)) < 0)){
+        return NRF24_ERROR;
+    }
+    return NRF24_OK;
+};
 
-    return ( (result & 1) == 0);
+/**
+ * @brief Register a handler for one or more events, NULL removes it. 
+ * 
+ * @param events: Mask of NRF24_RX_DR, NRF24_TX_DS and NRF24_TX_DF. 
+ * @param handler: Called from nRF24_update after the flag has been cleared. An 
+ *  RX_DR handler should drain the RX FIFO (nRF24_readBurst). 
+ * @param arg: Passed to the handler. 
+ * @return nrf24_status_t 
+ */
+nrf24_status_t nRF24_onEvent(nrf24_t *radio, nrf24_irq_flags_t events, nrf24_event_cb_t handler, void *arg){
+    if ((events & ~NRF24_IRQ_ALL) || (events == NRF24_IRQ_NONE)){
+        return NRF24_ARG_INVALID;
+    }
+
+    for (size_t i = 0u; i < (sizeof(event_flags) / sizeof(event_flags[0])); ++i){
+        if (events & event_flags[i]){
+            radio->handlers[i]     = handler;
+            radio->handler_args[i] = arg;
+        }
+    }
+    return NRF24_OK;
 };
 
+/**
+ * @brief Read STATUS once, clear the raised flags and dispatch them to their handlers. 
+ * 
+ * With nRF24_attachIrq this is free while no edge was seen, else it polls STATUS. 
+ * 
+ * @return nrf24_status_t 
+ */
+nrf24_status_t nRF24_update(nrf24_t *radio){
+    nrf24_status_t    status = NRF24_OK;
+    nrf24_irq_flags_t flags  = NRF24_IRQ_NONE;
+
+    if (radio->irq_attached && !radio->irq_pending){
+        return NRF24_OK;
+    }
+    /* Clear before reading, an edge from here on triggers another update. */
+    radio->irq_pending = false;
+
+    /* Only the status read and clear hold the bus, the handlers take it themselves. */
+    (void)nRF24_acquireBus(radio);
+    flags = (nrf24_irq_flags_t)(_updateStatus(radio) & NRF24_IRQ_ALL);
+    if (flags != NRF24_IRQ_NONE){
+        status = nRF24_clearStatusFlags(radio, flags);
+    }
+    if (flags & NRF24_TX_DF){
+        (void)_observeTx(radio);
+    }
+#ifdef NRF24_LATENCY
+    if (!(flags & NRF24_RX_DR)){
+        /* A TX event, no payload to time. */
+        radio->lat_irq_pending = false;
+    }
+#endif
+    (void)nRF24_releaseBus(radio);
+
+    for (size_t i = 0u; i < (sizeof(event_flags) / sizeof(event_flags[0])); ++i){
+        if ((flags & event_flags[i]) && (radio->handlers[i] != NULL)){
+            radio->handlers[i](radio, event_flags[i], radio->handler_args[i]);
+        }
+    }
+    return status;
+};
 
-nrf24_status_t nRF24_powerUp(void){
-    // if not powered up then power up and wait for the radio to initialize
-    if (!(config_reg & _BV(PWR_UP))) {
-        config_reg |= _BV(PWR_UP);
-        (void)_writeRegister(NRF_CONFIG, config_reg);
 
-        // For nRF24L01+ to go from power down mode to TX or RX mode it must first pass through stand-by mode.
-        // There must be a delay of Tpd2stby (see Table 16.) after the nRF24L01+ leaves power down mode before
-        // the CEis set high. - Tpd2stby can be up to 5ms per the 1.0 datasheet
-        machine->sleep.ms(5u);
+/**
+ * @brief Power up the radio, without waiting for it. 
+ * 
+ * For nRF24L01+ to go from power down mode to TX or RX mode it must first pass through 
+ *  stand-by mode. There must be a delay of Tpd2stby (see Table 16.) after the nRF24L01+ 
+ *  leaves power down mode before CE is set high. Registers can be used meanwhile, the 
+ *  first CE high waits for what is left of it. Use nRF24_isReady to do other work instead. 
+ * 
+ * @return nrf24_status_t 
+ */
+nrf24_status_t nRF24_powerUp(nrf24_t *radio){
+    if (!(radio->regs[NRF_CONFIG] & _BV(PWR_UP))) {
+        radio->regs[NRF_CONFIG] |= _BV(PWR_UP);
+        (void)_writeRegister(radio, NRF_CONFIG, radio->regs[NRF_CONFIG]);
+
+        radio->state         = NRF24_STATE_POWERING_UP;
+        radio->ready_at      = machine->time.micros() + NRF24_TPD2STBY_US;
+        radio->ready_pending = true;
     }
     return NRF24_OK;
 }
 
-nrf24_status_t nRF24_powerDown(void){
-    (void)ce(LOW); // Guarantee CE is low on powerDown
-    config_reg = (uint8_t)(config_reg & ~_BV(PWR_UP));
-    (void)_writeRegister(NRF_CONFIG, config_reg);
+/**
+ * @brief Get the power/mode state, windows that have passed are applied first. 
+ * 
+ * @param state: The current state. 
+ * @param ready_at_us: Optional, machine->time.micros() at which the current window 
+ *  (power up, PLL settle or RX to TX turnaround) ends, now when there is none. 
+ * @return nrf24_status_t 
+ */
+nrf24_status_t nRF24_getState(nrf24_t *radio, nrf24_state_t *state, uint32_t *ready_at_us){
+    if (state == NULL){
+        return NRF24_NULL_POINTER;
+    }
+
+    (void)nRF24_isReady(radio);
+    *state = radio->state;
+    if (ready_at_us != NULL){
+        *ready_at_us = radio->ready_pending ? radio->ready_at : machine->time.micros();
+    }
+    return NRF24_OK;
+};
+
+/**
+ * @brief Check if the current window has passed, so CE can go high without waiting. 
+ * 
+ * @return true: Ready, false: nRF24_getState tells until when. 
+ */
+bool nRF24_isReady(nrf24_t *radio){
+    if (!radio->ready_pending){
+        return true;
+    }
+    if ((int32_t)(machine->time.micros() - radio->ready_at) < 0){
+        return false;
+    }
+
+    radio->ready_pending = false;
+    if (radio->state == NRF24_STATE_POWERING_UP){
+        radio->state = NRF24_STATE_STANDBY;
+    } else if (radio->state == NRF24_STATE_RX_SETTLING){
+        radio->state = NRF24_STATE_RX;
+    }
+    return true;
+};
+
+nrf24_status_t nRF24_powerDown(nrf24_t *radio){
+    (void)ce(radio, LOW); // Guarantee CE is low on powerDown
+    radio->regs[NRF_CONFIG] = (uint8_t)(radio->regs[NRF_CONFIG] & ~_BV(PWR_UP));
+    (void)_writeRegister(radio, NRF_CONFIG, radio->regs[NRF_CONFIG]);
+    radio->state = NRF24_STATE_POWER_DOWN;
     return NRF24_OK;
 }
 
 
-nrf24_status_t nRF24_setPayloadSize(uint8_t size){
+nrf24_status_t nRF24_setPayloadSize(nrf24_t *radio, uint8_t size){
     nrf24_status_t status = NRF24_OK; 
 
     uint8_t idx = 0u;
@@ -154,22 +664,24 @@ nrf24_status_t nRF24_setPayloadSize(uint8_t size){
         status = NRF24_ARG_INVALID;
     } else {
         /* Ensure that all pipes have the same payload size */
+        (void)nRF24_acquireBus(radio);
         for (idx = 0u; idx < 6u; ++idx) {
             pipe_req = RX_PW_P0 + idx; 
-            status = _writeRegister(pipe_req, size);
+            status = _writeRegister(radio, pipe_req, size);
         }
+        (void)nRF24_releaseBus(radio);
     }
 
     if (status == NRF24_OK){
-        /* Sync with global _cfg struct */
-        _cfg->payloadSize = size; 
+        /* Sync with the radio cfg struct */
+        radio->cfg.payloadSize = size; 
     }
 
     return status;
 };
 
 
-nrf24_status_t nRF24_setAddressWidth(uint8_t size){
+nrf24_status_t nRF24_setAddressWidth(nrf24_t *radio, uint8_t size){
     nrf24_status_t status = NRF24_OK;
 
     if ((size < NRF24_MIN_ADDRESS_WIDTH) || (size > NRF24_MAX_ADDRESS_WIDTH)) {
@@ -177,18 +689,18 @@ nrf24_status_t nRF24_setAddressWidth(uint8_t size){
     } else {
         /* SETUP_AW register expects: 0x01 for 3 bytes, 0x02 for 4 bytes, 0x03 for 5 bytes */
         uint8_t reg_val = size - 2u;
-        status = _writeRegister(SETUP_AW, reg_val);
+        status = _writeRegister(radio, SETUP_AW, reg_val);
     }
 
     if (status == NRF24_OK){
         /* Set the address width in the global config */
-        _cfg->addressWidth = size;
+        radio->cfg.addressWidth = size;
     }
 
     return status;
 }
 
-nrf24_status_t nRF24_setRetries(uint8_t delay, uint8_t count){
+nrf24_status_t nRF24_setRetries(nrf24_t *radio, uint8_t delay, uint8_t count){
     nrf24_status_t status = NRF24_OK;
 
     if ( delay > 15u ) {
@@ -201,21 +713,21 @@ nrf24_status_t nRF24_setRetries(uint8_t delay, uint8_t count){
             So make sure delay is left shifted 4 bits. 
             1111 == 15, so check max value for 15.  
         */
-        status = _writeRegister(SETUP_RETR, ((delay << 4u) | ( count )) );
+        status = _writeRegister(radio, SETUP_RETR, ((delay << 4u) | ( count )) );
     }
 
     if (status == NRF24_OK){
-        /* Update _cfg */
-        _cfg->retries.count = count;
-        _cfg->retries.delay = delay;
+        /* Update cfg */
+        radio->cfg.retries.count = count;
+        radio->cfg.retries.delay = delay;
     }
 
     return status; 
 }
 
-nrf24_status_t nRF24_setDataRate(nrf24_datarate_t rate){
+nrf24_status_t nRF24_setDataRate(nrf24_t *radio, nrf24_datarate_t rate){
     nrf24_status_t status         = NRF24_OK; 
-    uint8_t        current_rate   = 0u; 
+    uint8_t        current_rate   = radio->regs[RF_SETUP]; 
     uint8_t        new_rate       = 0u; 
 
     /* 
@@ -241,59 +753,47 @@ nrf24_status_t nRF24_setDataRate(nrf24_datarate_t rate){
 
     if (rate >= NRF24_MAX_RATE){
         status = NRF24_ARG_INVALID;
-    } else if (_readRegister(RF_SETUP, &current_rate) != NRF24_OK) {
-        status = NRF24_ERROR;
     } else {
-        (void)_dataRateConversion(rate, &new_rate);
+        (void)_dataRateConversion(radio, rate, &new_rate);
 
         current_rate = (current_rate & ~(_BV(RF_DR_LOW) | _BV(RF_DR_HIGH)));
         current_rate |= new_rate; 
 
-        status = _writeRegister(RF_SETUP, current_rate);
-
-        /* Check if the register is set correctly, !! reused new_rate !! */
-        status = _readRegister(RF_SETUP, &new_rate);
-        if (new_rate == current_rate){
-            status = NRF24_OK;
-        }
-        else {
-            status = NRF24_ERROR;
-        }
+        /* Use nRF24_verifyRegisters() to check the chip if needed. */
+        status = _writeRegister(radio, RF_SETUP, current_rate);
     }
 
     if (status == NRF24_OK){
-        /* Update _cfg */
-        _cfg->datarate = rate; 
+        /* Update cfg */
+        radio->cfg.datarate = rate; 
     }
 
     return status; 
 }
 
-nrf24_status_t nRF24_setChannel(uint8_t channel){
+nrf24_status_t nRF24_setChannel(nrf24_t *radio, uint8_t channel){
     nrf24_status_t status = NRF24_OK;
 
     if (channel > NRF24_MAX_RF_CHANNEL) {
         status = NRF24_ARG_INVALID; 
     } else {
-        status = _writeRegister(RF_CH, channel);
+        status = _writeRegister(radio, RF_CH, channel);
     }
 
     if (status == NRF24_OK){
-        /* Update _cfg */
-        _cfg->channel = channel; 
+        /* Update cfg */
+        radio->cfg.channel = channel; 
     }
 
     return status; 
 };
 
-nrf24_status_t nRF24_setPALevel(nrf24_pa_dbm_t level, bool enableLna){
+nrf24_status_t nRF24_setPALevel(nrf24_t *radio, nrf24_pa_dbm_t level, bool enableLna){
     nrf24_status_t status = NRF24_OK;
-    uint8_t current_setup = 0u; 
+    uint8_t current_setup = radio->regs[RF_SETUP]; 
 
     if (level >= NRF24_PA_ERROR){
         status = NRF24_ARG_INVALID;
-    } else if (_readRegister(RF_SETUP, &current_setup) != NRF24_OK) {
-        status = NRF24_ERROR;
     } else {
         /* Clear the interested bits.  */
         current_setup &= 0xF8; /* Same as: 1111 1000 */
@@ -303,46 +803,43 @@ nrf24_status_t nRF24_setPALevel(nrf24_pa_dbm_t level, bool enableLna){
         */
         current_setup |= (level << 1u) + enableLna;
 
-        status = _writeRegister(RF_SETUP, current_setup);
+        status = _writeRegister(radio, RF_SETUP, current_setup);
     }
 
     if (status == NRF24_OK){
-        /* Update _cfg */
-        _cfg->PA.level = level; 
-        _cfg->PA.lnaEnabled = enableLna; 
+        /* Update cfg */
+        radio->cfg.PA.level = level; 
+        radio->cfg.PA.lnaEnabled = enableLna; 
     }
 
     return status; 
 };
 
-nrf24_status_t nRF24_setCrcLength(nrf24_crclength_t length){
+nrf24_status_t nRF24_setCrcLength(nrf24_t *radio, nrf24_crclength_t length){
     nrf24_status_t status = NRF24_OK;
-    // uint8_t current_config = 0u; 
 
     if (length >= NRF24_CRC_ERROR){
         status = NRF24_ARG_INVALID;
-    } else if (_readRegister(NRF_CONFIG, &config_reg) != NRF24_OK){
-        status = NRF24_ERROR;
     } else {
         /* Clear the current bits: 3 (CRC_EN) and 2 (Crc_length) */
-        config_reg &= ~(_BV(CRCO) | _BV(EN_CRC) );
+        radio->regs[NRF_CONFIG] &= ~(_BV(CRCO) | _BV(EN_CRC) );
 
         if (length == NRF24_CRC_DISABLED){
             /* Clear bit 2, done in previous step */
         } else if (length == NRF24_CRC_8){
             /* Clear bit 2, set bit 3*/
-            config_reg |= _BV(EN_CRC);
+            radio->regs[NRF_CONFIG] |= _BV(EN_CRC);
         } else if (length == NRF24_CRC_16){
             /* Set both bits 3 and 2. */
-            config_reg |= (_BV(CRCO) | _BV(EN_CRC));
+            radio->regs[NRF_CONFIG] |= (_BV(CRCO) | _BV(EN_CRC));
         }
 
-        status = _writeRegister(NRF_CONFIG, config_reg);
+        status = _writeRegister(radio, NRF_CONFIG, radio->regs[NRF_CONFIG]);
     }
 
     if (status == NRF24_OK){
-        /* Update _cfg */
-        _cfg->crc = length;
+        /* Update cfg */
+        radio->cfg.crc = length;
     }
 
     return status; 
@@ -355,7 +852,7 @@ nrf24_status_t nRF24_setCrcLength(nrf24_crclength_t length){
  * @param enable 
  * @return nrf24_status_t 
  */
-nrf24_status_t nRF24_setAutoAck(bool enable){
+nrf24_status_t nRF24_setAutoAck(nrf24_t *radio, bool enable){
     nrf24_status_t status = NRF24_OK; 
 
        
@@ -363,19 +860,19 @@ nrf24_status_t nRF24_setAutoAck(bool enable){
         /* Write: 0011 1111 
             Auto ack for all pipes. 
         */
-        status = _writeRegister(EN_AA, 0x3F); 
+        status = _writeRegister(radio, EN_AA, 0x3F); 
     } else {
-        if (_writeRegister(EN_AA, 0) != NRF24_OK){
+        if (_writeRegister(radio, EN_AA, 0) != NRF24_OK){
             status = NRF24_ERROR;
-        } else if (_cfg->ack.ackPayload){
+        } else if (radio->cfg.ack.ackPayload){
             /* Also disableAckPayload.. */
-            status = nRF24_setAckPayload(false);
+            status = nRF24_setAckPayload(radio, false);
         }
     }
 
     if (status == NRF24_OK){
-        /* Update _cfg */
-        _cfg->ack.autoAck = enable;
+        /* Update cfg */
+        radio->cfg.ack.autoAck = enable;
     }
 
     return status; 
@@ -389,28 +886,28 @@ nrf24_status_t nRF24_setAutoAck(bool enable){
  * @param enable 
  * @return * nrf24_status_t 
  */
-nrf24_status_t nRF24_setAckPayload(bool enable){
+nrf24_status_t nRF24_setAckPayload(nrf24_t *radio, bool enable){
     nrf24_status_t status          = NRF24_OK; 
-    uint8_t        current_feature = 0u;
+    uint8_t        current_feature = radio->regs[FEATURE];
 
-    if (_readRegister(FEATURE, &current_feature) != NRF24_OK){
-        status = NRF24_ERROR;
-    } else if (enable == true){
+    (void)nRF24_acquireBus(radio);
+    if (enable == true){
         /* Enable AckPayloads, and DynamicPayloads. */
         current_feature |= (_BV(EN_ACK_PAY));
-        if (_writeRegister(FEATURE, current_feature) != NRF24_OK) {
+        if (_writeRegister(radio, FEATURE, current_feature) != NRF24_OK) {
             status = NRF24_ERROR;
-        } else if (nRF24_setDynamicPayloadLength(true) != NRF24_OK){
+        } else if (nRF24_setDynamicPayloadLength(radio, true) != NRF24_OK){
             status = NRF24_ERROR;
         }
     } else if (enable == false) {
         /* Disable AckPayloads, but ignore dynamic payloads.. */
         current_feature &= ~_BV(EN_ACK_PAY);
-        status = _writeRegister(FEATURE, current_feature);
+        status = _writeRegister(radio, FEATURE, current_feature);
     }
+    (void)nRF24_releaseBus(radio);
 
     if (status == NRF24_OK){
-        _cfg->ack.ackPayload = enable; 
+        radio->cfg.ack.ackPayload = enable; 
     }
     
     return status; 
@@ -424,43 +921,39 @@ nrf24_status_t nRF24_setAckPayload(bool enable){
  * @param enable 
  * @return * nrf24_status_t 
  */
-nrf24_status_t nRF24_setDynamicPayloadLength(bool enable){
+nrf24_status_t nRF24_setDynamicPayloadLength(nrf24_t *radio, bool enable){
     nrf24_status_t status        = NRF24_OK; 
-    uint8_t        current_dynpd   = 0u;
-    uint8_t        current_feature = 0u;
+    uint8_t        current_dynpd   = radio->regs[DYNPD];
+    uint8_t        current_feature = radio->regs[FEATURE];
 
-    if (_readRegister(DYNPD, &current_dynpd) != NRF24_OK){
-        status = NRF24_ERROR;
-    } 
-    else if (_readRegister(FEATURE, &current_feature) != NRF24_OK){
-        status = NRF24_ERROR;
-    } 
-    else if (enable == true){
+    (void)nRF24_acquireBus(radio);
+    if (enable == true){
         /* Enable dynamic length on all pipes */
         current_dynpd |= (_BV(DPL_P5) | _BV(DPL_P4) | _BV(DPL_P3) | _BV(DPL_P2) | _BV(DPL_P1) | _BV(DPL_P0));
-        status = _writeRegister(DYNPD, current_dynpd);
+        status = _writeRegister(radio, DYNPD, current_dynpd);
 
         /* Enable DPL feature */
         current_feature |= _BV(EN_DPL);
-        status = _writeRegister(FEATURE, current_feature);
+        status = _writeRegister(radio, FEATURE, current_feature);
 
         /* Enable Auto Ack */
-        status = nRF24_setAutoAck(true);
+        status = nRF24_setAutoAck(radio, true);
     } 
     else if (enable == false){
         /* Disable dynamic length on all pipes */
         current_dynpd = 0u; 
-        status = _writeRegister(DYNPD, current_dynpd);
+        status = _writeRegister(radio, DYNPD, current_dynpd);
 
         /* Disable DPL feature */
         current_feature &= ~_BV(EN_DPL);
-        status = _writeRegister(FEATURE, current_feature);
+        status = _writeRegister(radio, FEATURE, current_feature);
 
         /* Dont disable autoack.. let the user decided.. */
     }
+    (void)nRF24_releaseBus(radio);
 
     if (status == NRF24_OK){
-        _cfg->dynamicPayloads = enable; 
+        radio->cfg.dynamicPayloads = enable; 
     }
 
     return status; 
@@ -472,321 +965,1135 @@ nrf24_status_t nRF24_setDynamicPayloadLength(bool enable){
  * @param enable 
  * @return * nrf24_status_t 
  */
-nrf24_status_t nRF24_setDynamicAck(bool enable){
+nrf24_status_t nRF24_setDynamicAck(nrf24_t *radio, bool enable){
     nrf24_status_t status          = NRF24_OK;
-    uint8_t        current_feature = 0u;
+    uint8_t        current_feature = radio->regs[FEATURE];
     
-    if (_readRegister(FEATURE, &current_feature) != NRF24_OK){
-        status = NRF24_ERROR;
-    } else if (enable == true){
+    if (enable == true){
         current_feature |= _BV(EN_DYN_ACK);
-        status = _writeRegister(FEATURE, current_feature);
+        status = _writeRegister(radio, FEATURE, current_feature);
     } else if (enable == false){
         current_feature &= ~_BV(EN_DYN_ACK);
-        status = _writeRegister(FEATURE, current_feature);        
+        status = _writeRegister(radio, FEATURE, current_feature);        
     }
 
     if (status == NRF24_OK){
-        _cfg->ack.dynamicAck = enable;
+        radio->cfg.ack.dynamicAck = enable;
     }
 
     return status; 
 }
 
-nrf24_status_t nRF24_flushRx(){
-    (void)printf("[NRF24] - Flushing RX\r\n");
-    return _readRegisternb(FLUSH_RX, NULL, 0);
+nrf24_status_t nRF24_flushRx(nrf24_t *radio){
+    radio->stats.flush_rx++;
+    radio->rx_was_full = false;
+    return _readRegisternb(radio, FLUSH_RX, NULL, 0);
 };
 
-nrf24_status_t nRF24_flushTx(){
-    (void)printf("[NRF24] - Flushing TX\r\n");
-    return _readRegisternb(FLUSH_TX, NULL, 0);
+nrf24_status_t nRF24_flushTx(nrf24_t *radio){
+    radio->stats.flush_tx++;
+#ifdef NRF24_LATENCY
+    radio->lat_tx_pending = false;
+#endif
+    return _readRegisternb(radio, FLUSH_TX, NULL, 0);
 };
 
 
-nrf24_status_t nRF24_openReadingPipe(uint8_t pipe, const uint8_t *address){
-    nrf24_status_t status = NRF24_OK; 
-    uint8_t current_rxaddre = 0u;
+/**
+ * @brief Reload the register shadow from the chip. 
+ * 
+ * Use this when the chip may have been reset behind the driver's back (brown-out, 
+ *  power cycle), all following setters then work on the real chip state again.
+ * 
+ * @return nrf24_status_t 
+ */
+nrf24_status_t nRF24_syncRegisters(nrf24_t *radio){
+    nrf24_status_t status = NRF24_OK;
+    uint8_t        idx    = 0u;
 
-    if (pipe > 5u){
-        status = NRF24_ARG_INVALID;
-    } else {
-        if (pipe == 0u){
-            (void)memcpy(pipe0_cfg.readAddress, address, _cfg->addressWidth);
-            pipe0_is_rx = true;    
-        }
+    (void)nRF24_acquireBus(radio);
+    for (idx = 0u; (idx < sizeof(shadow_regs)) && (status == NRF24_OK); ++idx) {
+        status = _readRegister(radio, shadow_regs[idx], &radio->regs[shadow_regs[idx]]);
+    }
 
-        if (pipe > 1u){
-            // For pipes 2-5, only write the LSB
-            _writeRegisternb(pipe_reg_address[pipe], address, 1);
-        }
-        // avoid overwriting the TX address on pipe 0 while still in TX mode.
-        // NOTE, the cached RX address on pipe 0 is written when startListening() is called.
-        else if (_isinTxMode() || pipe != 0){
-            _writeRegisternb(pipe_reg_address[pipe], address, _cfg->addressWidth);
-        }
-        
-        // Note it would be more efficient to set all of the bits for all open
-        // pipes at once.  However, I thought it would make the calling code
-        // more simple to do it this way.
-        (void)_readRegister(EN_RXADDR, &current_rxaddre);
-        _writeRegister(EN_RXADDR,  ( current_rxaddre | _BV(pipe_enn_bits[pipe])) );
+    for (idx = 0u; (idx < sizeof(shadow_addr_regs)) && (status == NRF24_OK); ++idx) {
+        status = _readRegisternb(radio, shadow_addr_regs[idx], 
+            _shadowAddress(radio, shadow_addr_regs[idx]), NRF24_MAX_ADDRESS_WIDTH);
     }
+    (void)nRF24_releaseBus(radio);
 
-    return status; 
-};
+    return status;
+}
 
-nrf24_status_t nRF24_closeReadingPipe(uint8_t pipe){
-    uint8_t current_rxaddr = 0u; 
+/**
+ * @brief Compare the register shadow against the chip, without modifying either. 
+ * 
+ * ! A mismatch normally means the chip has reset, call nRF24_syncRegisters() 
+ *  or re-apply the configuration to recover. 
+ * 
+ * @param match: true if every shadowed register equals the chip.
+ * @return nrf24_status_t 
+ */
+nrf24_status_t nRF24_verifyRegisters(nrf24_t *radio, bool *match){
+    nrf24_status_t status = NRF24_OK;
+    uint8_t        idx    = 0u;
+    uint8_t        value  = 0u;
+    uint8_t        addr[NRF24_MAX_ADDRESS_WIDTH];
 
-    _readRegister(EN_RXADDR, &current_rxaddr);
-    _writeRegister(EN_RXADDR, (current_rxaddr & ~_BV(pipe_enn_bits[pipe])));
+    if (match == NULL){
+        return NRF24_NULL_POINTER;
+    }
 
-    if (!pipe) {
-        // keep track of pipe 0's RX state to avoid null vs 0 in addr cache
-        pipe0_is_rx = false;
+    *match = true; 
+    (void)nRF24_acquireBus(radio);
+    for (idx = 0u; (idx < sizeof(shadow_regs)) && (status == NRF24_OK); ++idx) {
+        status = _readRegister(radio, shadow_regs[idx], &value);
+        *match = *match && (value == radio->regs[shadow_regs[idx]]);
     }
-    return NRF24_OK;
-};
 
-nrf24_status_t nRF24_startListening(void){
-    
-    config_reg |= _BV(PRIM_RX);
-    _writeRegister(NRF_CONFIG, config_reg);
-    _writeRegister(NRF_STATUS, NRF24_IRQ_ALL);
-    ce(HIGH);
+    /* Only the configured address width is meaningful. */
+    for (idx = 0u; (idx < sizeof(shadow_addr_regs)) && (status == NRF24_OK); ++idx) {
+        status = _readRegisternb(radio, shadow_addr_regs[idx], addr, radio->cfg.addressWidth);
+        *match = *match && (memcmp(addr, _shadowAddress(radio, shadow_addr_regs[idx]), radio->cfg.addressWidth) == 0);
+    }
+    (void)nRF24_releaseBus(radio);
+
+    return status;
+}
+
+/**
+ * @brief Apply a complete configuration in one go. 
+ * 
+ * The wanted register values are compared against the register shadow, and only 
+ *  the registers that differ are written (one batch, see HAL_SPI_t.batch). Switching between 
+ *  two profiles therefore only costs the registers in which they differ. 
+ * 
+ * ! cfg->gpio is ignored, the pins are fixed by nRF24_init.
+ * ! Like the setters, ackPayloads enable dynamicPayloads, which in turn enables autoAck.
+ * 
+ * @param cfg 
+ * @return nrf24_status_t: NRF24_ARG_INVALID if any field is out of range, nothing is written then. 
+ */
+nrf24_status_t nRF24_applyConfig(nrf24_t *radio, const nrf24_cfg_t *cfg){
+    nrf24_status_t status = NRF24_OK;
+    uint8_t        idx    = 0u;
+    uint8_t        reg    = 0u;
+    uint8_t        image[NRF24_REG_COUNT];
+
+    if (cfg == NULL){
+        status = NRF24_NULL_POINTER;
+    } else {
+        status = _buildImage(radio, cfg, image);
+    }
 
-    if (pipe0_is_rx){
-        _writeRegisternb(RX_ADDR_P0, pipe0_cfg.readAddress, _cfg->addressWidth);
+    for (idx = 0u; (idx < sizeof(config_regs)) && (status == NRF24_OK); ++idx) {
+        reg = config_regs[idx];
+        if (image[reg] != radio->regs[reg]){
+            _batchWrite(radio, reg, &image[reg], 1u);
+        }
+    }
+    _batchSubmit(radio);
+
+    if (status == NRF24_OK){
+        /* Sync with the radio cfg struct, but keep the pins. */
+        radio->cfg.addressWidth    = cfg->addressWidth;
+        radio->cfg.payloadSize     = cfg->payloadSize;
+        radio->cfg.channel         = cfg->channel;
+        radio->cfg.datarate        = cfg->datarate;
+        radio->cfg.crc             = cfg->crc;
+        radio->cfg.dynamicPayloads = cfg->dynamicPayloads || cfg->ack.ackPayload;
+        radio->cfg.retries         = cfg->retries;
+        radio->cfg.ack             = cfg->ack;
+        radio->cfg.ack.autoAck     = cfg->ack.autoAck || radio->cfg.dynamicPayloads;
+        radio->cfg.PA              = cfg->PA;
+    }
+
+    return status;
+}
+
+nrf24_status_t nRF24_openReadingPipe(nrf24_t *radio, uint8_t pipe, const uint8_t *address){
+    nrf24_status_t status = NRF24_OK; 
+
+    if (pipe > 5u){
+        status = NRF24_ARG_INVALID;
+    } else {
+        if (pipe == 0u){
+            (void)memcpy(radio->pipe0_cfg.readAddress, address, radio->cfg.addressWidth);
+            radio->pipe0_is_rx = true;    
+        }
+
+        (void)nRF24_acquireBus(radio);
+        if (pipe > 1u){
+            // For pipes 2-5, only write the LSB
+            _writeRegisternb(radio, pipe_reg_address[pipe], address, 1);
+        }
+        // avoid overwriting the TX address on pipe 0 while still in TX mode.
+        // NOTE, the cached RX address on pipe 0 is written when startListening() is called.
+        else if (_isinTxMode(radio) || pipe != 0){
+            _writeRegisternb(radio, pipe_reg_address[pipe], address, radio->cfg.addressWidth);
+        }
+        
+        // Note it would be more efficient to set all of the bits for all open
+        // pipes at once.  However, I thought it would make the calling code
+        // more simple to do it this way.
+        _writeRegister(radio, EN_RXADDR,  ( radio->regs[EN_RXADDR] | _BV(pipe_enn_bits[pipe])) );
+        (void)nRF24_releaseBus(radio);
+    }
+
+    return status; 
+};
+
+nrf24_status_t nRF24_closeReadingPipe(nrf24_t *radio, uint8_t pipe){
+    _writeRegister(radio, EN_RXADDR, (radio->regs[EN_RXADDR] & ~_BV(pipe_enn_bits[pipe])));
+
+    if (!pipe) {
+        // keep track of pipe 0's RX state to avoid null vs 0 in addr cache
+        radio->pipe0_is_rx = false;
+    }
+    return NRF24_OK;
+};
+
+nrf24_status_t nRF24_startListening(nrf24_t *radio){
+    uint8_t config = (uint8_t)(radio->regs[NRF_CONFIG] | _BV(PRIM_RX));
+    uint8_t clear  = NRF24_IRQ_ALL;
+    uint8_t rxaddr = (uint8_t)(radio->regs[EN_RXADDR] & ~_BV(pipe_enn_bits[0]));
+
+    /* One batch, CE goes high once the RX configuration is complete. */
+    _batchWrite(radio, NRF_CONFIG, &config, 1u);
+    _batchWrite(radio, NRF_STATUS, &clear, 1u);
+
+    if (radio->pipe0_is_rx){
+        _batchWrite(radio, RX_ADDR_P0, radio->pipe0_cfg.readAddress, radio->cfg.addressWidth);
     } else{
-        nRF24_closeReadingPipe(0);
+        _batchWrite(radio, EN_RXADDR, &rxaddr, 1u);
     }
+    _batchSubmit(radio);
 
+    ce(radio, HIGH);
     return NRF24_OK;
 }
 
-nrf24_status_t nRF24_stopListening(void){
-    uint8_t current_addr_p0 = 0u; 
+nrf24_status_t nRF24_stopListening(nrf24_t *radio){
+    uint8_t config = 0u;
+    uint8_t rxaddr = 0u;
 
-    ce(LOW);
+    ce(radio, LOW);
 
-    machine->sleep.ms(1);
-    if (_cfg->ack.ackPayload){
-        nRF24_flushTx();
+    /* Let the last ACK go out, the first CE high for TX waits for what is left of it. */
+    _readyNotBefore(radio, radio->txDelay);
+
+    (void)nRF24_acquireBus(radio);
+    if (radio->cfg.ack.ackPayload){
+        nRF24_flushTx(radio);
     }
 
-    config_reg = (config_reg & ~_BV(PRIM_RX));
-    _writeRegister(NRF_CONFIG, config_reg);
+    config = (uint8_t)(radio->regs[NRF_CONFIG] & ~_BV(PRIM_RX));
+    rxaddr = (uint8_t)(radio->regs[EN_RXADDR] | _BV(pipe_enn_bits[0])); // Enable RX on pipe0
 
-    _writeRegisternb(RX_ADDR_P0, pipe0_cfg.writeAddress, _cfg->addressWidth);
+    _batchWrite(radio, NRF_CONFIG, &config, 1u);
+    _batchWrite(radio, RX_ADDR_P0, radio->pipe0_cfg.writeAddress, radio->cfg.addressWidth);
+    _batchWrite(radio, EN_RXADDR, &rxaddr, 1u);
+    _batchSubmit(radio);
 
-    _readRegister(RX_ADDR_P0, &current_addr_p0);
-    _writeRegister(EN_RXADDR, (current_addr_p0 | _BV(pipe_enn_bits[0]))); // Enable RX on pipe0
+    (void)nRF24_releaseBus(radio);
     return NRF24_OK;
 }
 
-nrf24_status_t nRF24_openWritingPipe(const uint8_t *address){
-    _writeRegisternb(RX_ADDR_P0, address, _cfg->addressWidth);
-    _writeRegisternb(TX_ADDR, address, _cfg->addressWidth);
-    memcpy(pipe0_cfg.writeAddress, address, _cfg->addressWidth);
+/**
+ * @brief nRF24_startListening for request/response links, in as few transactions as possible. 
+ * 
+ * The RX images of CONFIG, EN_RXADDR and RX_ADDR_P0 are derived from the register shadow 
+ *  up front, only the ones that differ are queued, together with the STATUS clear. They go 
+ *  out as one machine->spi.batch call when the backend owns CSN, else a transaction each. 
+ *  A ping-pong on pipe 1 writes CONFIG, EN_RXADDR and STATUS. CE goes high right away, 
+ *  RX is up after NRF24_TSTBY2A_US (nRF24_getState). 
+ * 
+ * @return nrf24_status_t 
+ */
+nrf24_status_t nRF24_fastStartListening(nrf24_t *radio){
+    uint8_t config = (uint8_t)(radio->regs[NRF_CONFIG] | _BV(PRIM_RX));
+    uint8_t rxaddr = (uint8_t)(radio->regs[EN_RXADDR] & ~_BV(pipe_enn_bits[0]));
+    uint8_t clear  = NRF24_IRQ_ALL;
+
+    (void)nRF24_acquireBus(radio);
+    if (radio->pipe0_is_rx){
+        rxaddr |= _BV(pipe_enn_bits[0]);
+        if (memcmp(radio->rx_addr[0u], radio->pipe0_cfg.readAddress, radio->cfg.addressWidth) != 0){
+            _batchWrite(radio, RX_ADDR_P0, radio->pipe0_cfg.readAddress, radio->cfg.addressWidth);
+        }
+    }
+    _batchUpdate(radio, NRF_CONFIG, config);
+    _batchUpdate(radio, EN_RXADDR, rxaddr);
+    _batchWrite(radio, NRF_STATUS, &clear, 1u);
+    _batchSubmit(radio);
+
+    ce(radio, HIGH);
+    (void)nRF24_releaseBus(radio);
+    return NRF24_OK;
+};
+
+/**
+ * @brief nRF24_stopListening for request/response links, in as few transactions as possible. 
+ * 
+ * The TX images of CONFIG, EN_RXADDR and RX_ADDR_P0 are derived from the register shadow 
+ *  up front, only the ones that differ are queued and submitted as one batch (see 
+ *  nRF24_fastStartListening). A ping-pong on pipe 1 writes CONFIG and EN_RXADDR. Nothing 
+ *  sleeps here, the txDelay turnaround is waited out by the next CE high, so work done 
+ *  meanwhile hides it. 
+ * 
+ * ! With ack payloads enabled the TX FIFO is still flushed, stale ack payloads would be sent. 
+ * 
+ * @return nrf24_status_t 
+ */
+nrf24_status_t nRF24_fastStopListening(nrf24_t *radio){
+    uint8_t config = (uint8_t)(radio->regs[NRF_CONFIG] & ~_BV(PRIM_RX));
+    uint8_t rxaddr = (uint8_t)(radio->regs[EN_RXADDR] | _BV(pipe_enn_bits[0]));
+
+    ce(radio, LOW);
+    _readyNotBefore(radio, radio->txDelay);
+
+    (void)nRF24_acquireBus(radio);
+    if (radio->cfg.ack.ackPayload){
+        (void)nRF24_flushTx(radio);
+    }
+
+    _batchUpdate(radio, NRF_CONFIG, config);
+    if (memcmp(radio->rx_addr[0u], radio->pipe0_cfg.writeAddress, radio->cfg.addressWidth) != 0){
+        _batchWrite(radio, RX_ADDR_P0, radio->pipe0_cfg.writeAddress, radio->cfg.addressWidth);
+    }
+    _batchUpdate(radio, EN_RXADDR, rxaddr);
+    _batchSubmit(radio);
+
+    (void)nRF24_releaseBus(radio);
+    return NRF24_OK;
+};
+
+nrf24_status_t nRF24_openWritingPipe(nrf24_t *radio, const uint8_t *address){
+    _writeRegisternb(radio, RX_ADDR_P0, address, radio->cfg.addressWidth);
+    _writeRegisternb(radio, TX_ADDR, address, radio->cfg.addressWidth);
+    memcpy(radio->pipe0_cfg.writeAddress, address, radio->cfg.addressWidth);
     return NRF24_OK;
 }
 
-nrf24_status_t nRF24_read(void *buffer, uint8_t length){
+nrf24_status_t nRF24_read(nrf24_t *radio, void *buffer, uint8_t length){
+    return nRF24_readPayload(radio, buffer, length, NULL);
+};
+
+/**
+ * @brief nRF24_read that also reports how many bytes were written into buffer. 
+ * 
+ * With dynamic payloads this is the on-air width (capped at length), otherwise 
+ *  length capped at the payload size. Nothing is copied in between, see _readPayload. 
+ * 
+ * @param received: May be NULL. 
+ * @return nrf24_status_t 
+ */
+nrf24_status_t nRF24_readPayload(nrf24_t *radio, void *buffer, uint8_t length, uint8_t *received){
     nrf24_status_t status = NRF24_OK;
+
+    if (received != NULL){
+        *received = 0u;
+    }
     
-    status = _readPayload(buffer, length);
+    (void)nRF24_acquireBus(radio);
+    status = _readPayload(radio, buffer, length, received);
 
-    /* Clear the IRQ.  */
-    status = _writeRegister(NRF_STATUS, NRF24_RX_DR);
+    /* Clear the IRQ, also when a corrupt payload was flushed.  */
+    if (_writeRegister(radio, NRF_STATUS, NRF24_RX_DR) != NRF24_OK){
+        status = NRF24_ERROR;
+    }
+    (void)nRF24_releaseBus(radio);
     return status;
 };
 
-nrf24_status_t nRF24_write(const void *buffer, uint8_t length, const bool multicast){
+/**
+ * @brief Get the width of the payload at the head of the RX FIFO (R_RX_PL_WID).
+ * 
+ * ! Only valid with dynamic payloads enabled. A width above 32 bytes means the 
+ *  payload is corrupt, the RX FIFO is then flushed as the datasheet requires. 
+ * 
+ * @param size: The width in bytes.  
+ * @return nrf24_status_t: NRF24_ERROR when the width was corrupt. 
+ */
+nrf24_status_t nRF24_getDynamicPayloadSize(nrf24_t *radio, uint8_t *size){
     nrf24_status_t status = NRF24_OK;
 
-    status = _writePayload(buffer, length, multicast);
+    if (size == NULL){
+        status = NRF24_NULL_POINTER;
+    } else if ((status = _readRegisternb(radio, R_RX_PL_WID, size, 1u)) != NRF24_OK){
+        /* Keep status */
+    } else if (*size > NRF24_MAX_PAYLOAD_SIZE){
+        TRACE_ERROR(radio, NRF24_ERROR);
+        (void)nRF24_flushRx(radio);
+        *size  = 0u;
+        status = NRF24_ERROR;
+    }
 
-    /* Clear the IRQ.  */
-    // _writeRegister(NRF_STATUS, NRF24_RX_DR);
-    ce(HIGH);
     return status;
 };
 
-nrf24_status_t nRF24_fastWrite(const void *buffer, uint8_t length, const bool multicast){
+/**
+ * @brief Drain every queued payload from the RX FIFO in one call. 
+ * 
+ * The pipe of each payload is taken from RX_P_NO, a 1 byte NOP follows each payload to 
+ *  see if more are waiting. RX_DR is cleared once before draining, instead of after every 
+ *  payload, so a payload that arrives meanwhile raises it (and the IRQ) again. 
+ * 
+ * With dynamic payloads only the on-air length is transferred, corrupt payloads are dropped. 
+ * ! If max frames are read while more are queued, use nRF24_getLastStatus() to check for leftovers.
+ * 
+ * @param frames: Array of at least max frames.
+ * @param max: The number of frames that fit in frames. 
+ * @param count: The number of frames that are read.  
+ * @return nrf24_status_t 
+ */
+nrf24_status_t nRF24_readBurst(nrf24_t *radio, nrf24_rx_frame_t *frames, size_t max, size_t *count){
     nrf24_status_t status = NRF24_OK;
+    uint8_t        pipe   = 0u;
+    uint8_t        length = 0u;
+    uint8_t        fifo   = 0u;
+
+    if ((frames == NULL) || (count == NULL)){
+        return NRF24_NULL_POINTER;
+    }
 
-    // Needed for linux: uint32_t timer = machine->sleep.millis(); 
+    *count = 0u;
+    (void)nRF24_acquireBus(radio);
+    /* FIFO_STATUS instead of a NOP, the status byte is the same and RX_FULL is counted for free. */
+    (void)_readRegister(radio, FIFO_STATUS, &fifo);
+    pipe   = (uint8_t)((radio->spi_status >> RX_P_NO) & 0x07);
 
-    while ( _updateStatus() & _BV(TX_FULL)){
-        if (nrf24_spi_status & NRF24_TX_DF){
+    if (pipe <= 5u){
+        /* Clear the IRQ before draining, a payload that lands meanwhile raises it again. */
+        status = _writeRegister(radio, NRF_STATUS, NRF24_RX_DR);
+    }
+
+    while ((*count < max) && (pipe <= 5u) && (status == NRF24_OK)) {
+        if (_readPayload(radio, frames[*count].data, NRF24_MAX_PAYLOAD_SIZE, &length) == NRF24_OK) {
+            frames[*count].pipe      = pipe;
+            frames[*count].length    = length;
+            frames[*count].timestamp = machine->time.micros();
+            (*count)++;
+        }
+        /* Else: a corrupt dynamic payload, which is discarded by flushing the RX FIFO. */
+
+        pipe = (uint8_t)((_updateStatus(radio) >> RX_P_NO) & 0x07);
+    }
+    (void)nRF24_releaseBus(radio);
+    return status;
+};
+
+/**
+ * @brief Send a payload and wait for its ACK, returning the payload that came with it. 
+ * 
+ * The PRX loads that payload up front with nRF24_writeAckPayload, so a downlink comes 
+ *  back inside the ACK without an RX/TX turnaround. Ack payloads need nRF24_setAckPayload 
+ *  on both sides. 
+ * 
+ * ! The radio must be in TX mode (nRF24_stopListening). 
+ * 
+ * @param buffer: The payload to send. 
+ * @param length: Length of the payload. 
+ * @param ack: Receives the ack payload, length is 0 for an empty ACK. 
+ * @return nrf24_status_t: NRF24_OK when acked, NRF24_ERROR on MAX_RT, NRF24_TIMEOUT when 
+ *  the radio didn't finish within NRF24_TX_TIMEOUT_MS. 
+ */
+nrf24_status_t nRF24_writeWithAck(nrf24_t *radio, const void *buffer, uint8_t length, nrf24_rx_frame_t *ack){
+    nrf24_status_t status = NRF24_OK;
+    uint32_t       timer  = 0u;
+    uint8_t        flags  = 0u;
+    uint8_t        arc    = 0u;
+
+    if ((buffer == NULL) || (ack == NULL)){
+        return NRF24_NULL_POINTER;
+    }
+
+    ack->pipe      = 0u;
+    ack->length    = 0u;
+    ack->timestamp = 0u;
+
+    status = _writePayload(radio, buffer, length, W_TX_PAYLOAD);
+    if (status != NRF24_OK){
+        return status;
+    }
+    _onTxPayload(radio);
+
+    ce(radio, HIGH);
+    timer = machine->time.millis();
+    while (!(_updateStatus(radio) & (NRF24_TX_DS | NRF24_TX_DF))){
+        if ((machine->time.millis() - timer) > NRF24_TX_TIMEOUT_MS){
+            status = NRF24_TIMEOUT;
+            break;
+        }
+    }
+    ce(radio, LOW);
+
+    flags = radio->spi_status;
+    if (status != NRF24_TIMEOUT){
+        /* Retransmits of this payload (ARC_CNT), and PLOS_CNT. */
+        arc = _observeTx(radio);
+    }
+
+    if (status == NRF24_TIMEOUT){
+        (void)nRF24_flushTx(radio);
+    } else if (flags & NRF24_TX_DF){
+        /* MAX_RT keeps the payload in the FIFO, drop it. */
+        (void)nRF24_flushTx(radio);
+        status = NRF24_ERROR;
+    } else if (((flags >> RX_P_NO) & 0x07) <= 5u){
+        /* The ack payload is in the RX FIFO before TX_DS is set. */
+        ack->pipe      = (uint8_t)((flags >> RX_P_NO) & 0x07);
+        ack->timestamp = machine->time.micros();
+        if (_readPayload(radio, ack->data, NRF24_MAX_PAYLOAD_SIZE, &ack->length) != NRF24_OK){
+            ack->length = 0u;
+            status      = NRF24_ERROR;
+        }
+    }
+
+    if (!(flags & NRF24_TX_DF)){
+        /* MAX_RT rounds are counted when STATUS is cleared. */
+        radio->stats.retransmits += arc;
+    }
+
+    if (status != NRF24_OK){
+        TRACE_ERROR(radio, status);
+    }
+    (void)_writeRegister(radio, NRF_STATUS, (NRF24_RX_DR | NRF24_TX_DS | NRF24_TX_DF));
+    return status;
+};
+
+/**
+ * @brief Load a payload that the PRX sends back in the next ACK on a pipe. 
+ * 
+ * Up to 3 ack payloads can be pending (they share the TX FIFO), each is used once. 
+ * 
+ * ! Requires nRF24_setAckPayload, ack payloads have a dynamic length. 
+ * 
+ * @param pipe: Pipe (0..5) whose next ACK carries the payload. 
+ * @param buffer: The payload. 
+ * @param length: Length of the payload, at most NRF24_MAX_PAYLOAD_SIZE. 
+ * @return nrf24_status_t: NRF24_ERROR if ack payloads are disabled or the TX FIFO is full. 
+ */
+nrf24_status_t nRF24_writeAckPayload(nrf24_t *radio, uint8_t pipe, const void *buffer, uint8_t length){
+    nrf24_status_t status = NRF24_OK;
+
+    if (buffer == NULL){
+        return NRF24_NULL_POINTER;
+    } else if ((pipe > 5u) || (length == 0u) || (length > NRF24_MAX_PAYLOAD_SIZE)){
+        return NRF24_ARG_INVALID;
+    } else if (!(radio->regs[FEATURE] & _BV(EN_ACK_PAY))){
+        return NRF24_ERROR;
+    }
+
+    /* Ack payloads imply dynamic payloads, so nothing is padded. */
+    (void)_writePayload(radio, buffer, length, (uint8_t)(W_ACK_PAYLOAD | (pipe & 0x07)));
+
+    /* The status byte is clocked out before the payload, a full FIFO dropped it. */
+    if (radio->spi_status & _BV(TX_FULL)){
+        status = NRF24_ERROR;
+        TRACE_ERROR(radio, status);
+    }
+    return status;
+};
+
+nrf24_status_t nRF24_write(nrf24_t *radio, const void *buffer, uint8_t length, const bool multicast){
+    nrf24_status_t status = NRF24_OK;
+
+    status = _writePayload(radio, buffer, length, multicast ? W_TX_PAYLOAD_NO_ACK : W_TX_PAYLOAD);
+    if (status == NRF24_OK){
+        _onTxPayload(radio);
+    }
+
+    /* Clear the IRQ.  */
+    // _writeRegister(radio, NRF_STATUS, NRF24_RX_DR);
+    ce(radio, HIGH);
+    return status;
+};
+
+nrf24_status_t nRF24_fastWrite(nrf24_t *radio, const void *buffer, uint8_t length, const bool multicast){
+    nrf24_status_t status = NRF24_OK;
+    uint32_t       timer  = machine->time.millis(); 
+
+    while ( _updateStatus(radio) & _BV(TX_FULL)){
+        if (radio->spi_status & NRF24_TX_DF){
+            TRACE_ERROR(radio, NRF24_ERROR);
             return NRF24_ERROR;
         }
 
-        // Needed for linux: if ((machine->sleep.millis() - timer) > 95u){
-        //     printf("help\n");
-        // }
+        /* Without this, a radio that stopped responding hangs the caller forever. */
+        if ((machine->time.millis() - timer) > NRF24_TX_TIMEOUT_MS){
+            TRACE_ERROR(radio, NRF24_TIMEOUT);
+            return NRF24_TIMEOUT;
+        }
     }
 
-    status = _writePayload(buffer, length, multicast);
-    ce(HIGH);
+    status = _writePayload(radio, buffer, length, multicast ? W_TX_PAYLOAD_NO_ACK : W_TX_PAYLOAD);
+    if (status == NRF24_OK){
+        _onTxPayload(radio);
+    }
+    ce(radio, HIGH);
 
     return status;
 };
 
+/**
+ * @brief Transmit a batch of payloads while keeping the 3 deep TX FIFO loaded. 
+ * 
+ * The FIFO is topped up until TX_FULL is seen, at that point exactly 3 payloads are 
+ *  queued so every payload loaded before them was acked. On MAX_RT the radio halts with 
+ *  the stuck payload at the head of the FIFO. If the FIFO is neither full nor down to one 
+ *  payload, it is counted (_countTxQueued), flushed and reloaded from the stuck payload. 
+ *  The stuck payload is retransmitted up to maxAttempts MAX_RT rounds, then dropped and 
+ *  the payloads behind it (never on air) are loaded again. REUSE_TX_PL is not used, with 
+ *  CE held high it would repeat the payload endlessly. 
+ * 
+ * The retransmits of a MAX_RT round are read from ARC_CNT. Those of the round that got 
+ *  the ACK are only known if the payload was seen on air alone or at the head of a full 
+ *  FIFO, so results[].retransmits is a lower bound. 
+ * 
+ * ! The radio must be in TX mode (nRF24_stopListening) with an empty TX FIFO. 
+ * 
+ * @param msgs: The payloads to send, in order.
+ * @param results: One result per message, NRF24_OK (acked), NRF24_ERROR (dropped after 
+ *  maxAttempts MAX_RT's) or NRF24_TIMEOUT (not completed within timeout_ms). 
+ * @param count: Number of msgs and results. 
+ * @param maxAttempts: MAX_RT rounds per payload before it is dropped, at least 1. 
+ * @param timeout_ms: Time budget for the whole batch, unsent payloads are flushed after it.  
+ * @return nrf24_status_t: NRF24_OK if all payloads are acked. 
+ */
+nrf24_status_t nRF24_writeBatch(nrf24_t *radio, const nrf24_tx_msg_t *msgs, nrf24_tx_result_t *results, 
+                                size_t count, uint8_t maxAttempts, uint32_t timeout_ms){
+    nrf24_status_t status = NRF24_OK;
+    uint32_t       timer  = machine->time.millis(); 
+    size_t         loaded = 0u;     /* Messages written into the TX FIFO */
+    size_t         head   = 0u;     /* Oldest message that isn't known to be acked */
+    uint8_t        queued = 0u;     /* Upper bound of the payloads in the TX FIFO (loaded - head) */
+    uint8_t        upper  = 0u;
+    uint8_t        fifo   = 0u;
+    uint8_t        arc    = 0u;
+    uint8_t        live   = 0u;     /* Highest ARC_CNT seen of head while it was on air */
+    bool           exact  = false;  /* The FIFO holds exactly queued payloads, head is on air */
+    size_t         stale  = 0u;     /* Head whose ARC_CNT may still be of an earlier payload */
+    size_t         idx    = 0u;
+
+    if ((msgs == NULL) || (results == NULL)){
+        return NRF24_NULL_POINTER;
+    } else if (maxAttempts == 0u){
+        return NRF24_ARG_INVALID;
+    }
+
+    (void)_readRegister(radio, FIFO_STATUS, &fifo);
+    if (!(fifo & _BV(TX_EMPTY))){
+        /* Unknown payloads in the FIFO would break the accounting. */
+        return NRF24_ERROR;
+    }
+
+    for (idx = 0u; idx < count; ++idx){
+        results[idx].status      = NRF24_TIMEOUT;
+        results[idx].attempts    = 0u;
+        results[idx].retransmits = 0u;
+    }
+
+    (void)_writeRegister(radio, NRF_STATUS, (NRF24_TX_DS | NRF24_TX_DF));
+    ce(radio, HIGH);
+
+    while (head < count){
+        if ((machine->time.millis() - timer) > timeout_ms){
+            status = NRF24_TIMEOUT;
+            break;
+        }
+
+        /* Top up, the status byte after each write tells if the FIFO became full. */
+        (void)_updateStatus(radio);
+        while (!(radio->spi_status & _BV(TX_FULL)) && (loaded < count)){
+            (void)_writePayload(radio, msgs[loaded].buffer, msgs[loaded].length, 
+                                msgs[loaded].multicast ? W_TX_PAYLOAD_NO_ACK : W_TX_PAYLOAD);
+            _onTxPayload(radio);
+            loaded++;
+            queued++;
+            (void)_updateStatus(radio);
+        }
+
+        /* Credit every payload that has left the FIFO, exact when full or empty. */
+        (void)_readRegister(radio, FIFO_STATUS, &fifo);
+        upper = (fifo & _BV(TX_EMPTY)) ? 0u : ((radio->spi_status & _BV(TX_FULL)) ? 3u : 2u);
+        while (queued > upper){
+            results[head].status       = NRF24_OK;
+            results[head].retransmits += live;
+            radio->stats.retransmits  += live;
+            live = 0u;
+            head++;
+            queued--;
+        }
+        exact = (upper == 3u) || (queued == 1u);
+
+        if (radio->spi_status & NRF24_TX_DF){
+            /* ARC_CNT of the stuck payload, the retransmits of this round. */
+            arc = _observeTx(radio);
+
+            if (!exact){
+                /* The FIFO is halted, count it and restart from the stuck payload. */
+                upper = _countTxQueued(radio);
+                (void)nRF24_flushTx(radio);
+                while (queued > upper){
+                    results[head].status       = NRF24_OK;
+                    results[head].retransmits += live;
+                    radio->stats.retransmits  += live;
+                    live = 0u;
+                    head++;
+                    queued--;
+                }
+                loaded = head;
+                queued = 0u;
+            }
+
+            results[head].attempts++;
+            results[head].retransmits += arc;
+            live = 0u;
+
+            if (results[head].attempts >= maxAttempts){
+                /* Drop it, and reload what was behind it. Those never left the radio. */
+                results[head].status = NRF24_ERROR;
+                status               = NRF24_ERROR;
+                TRACE_ERROR(radio, status);
+
+                if (exact){
+                    (void)nRF24_flushTx(radio);
+                }
+                head++;
+                loaded = head;
+                queued = 0u;
+            }
+
+            /* Clearing MAX_RT with CE toggled sends the head of the FIFO (again). */
+            stale = head;
+            (void)_writeRegister(radio, NRF_STATUS, (NRF24_TX_DS | NRF24_TX_DF));
+            ce(radio, LOW);
+            ce(radio, HIGH);
+        }
+        else if (exact && (queued > 0u) && (head != stale)){
+            /* Track the retransmits of the payload on air, ARC_CNT restarts per payload. */
+            arc  = _observeTx(radio);
+            live = rf24_max(live, arc);
+        }
+    }
+
+    if (head < count){
+        /* Timed out, make sure nothing is sent after returning. */
+        TRACE_ERROR(radio, NRF24_TIMEOUT);
+        (void)nRF24_flushTx(radio);
+    }
+
+    ce(radio, LOW);
+    (void)_writeRegister(radio, NRF_STATUS, (NRF24_TX_DS | NRF24_TX_DF));
+
+    return status;
+};
+
+
+/**
+ * @brief Snapshot of the link statistics, no SPI traffic. 
+ * 
+ * @param stats: Receives the counters since nRF24_init or nRF24_resetStats. 
+ * @return nrf24_status_t 
+ */
+nrf24_status_t nRF24_getStats(nrf24_t *radio, nrf24_stats_t *stats){
+    if ((radio == NULL) || (stats == NULL)){
+        return NRF24_NULL_POINTER;
+    }
+
+    *stats = radio->stats;
+    return NRF24_OK;
+};
+
+nrf24_status_t nRF24_resetStats(nrf24_t *radio){
+    if (radio == NULL){
+        return NRF24_NULL_POINTER;
+    }
+
+    (void)memset(&radio->stats, 0, sizeof(radio->stats));
+    return NRF24_OK;
+};
+
+/**
+ * @brief Copy out a latency histogram. Requires NRF24_LATENCY. 
+ * 
+ * @param which: The interval, see nrf24_latency_t. 
+ * @param hist: Receives the samples since nRF24_init or nRF24_resetHistograms. 
+ * @return nrf24_status_t: NRF24_ERROR when built without NRF24_LATENCY. 
+ */
+nrf24_status_t nRF24_getHistogram(nrf24_t *radio, nrf24_latency_t which, nrf24_histogram_t *hist){
+    if ((radio == NULL) || (hist == NULL)){
+        return NRF24_NULL_POINTER;
+    } else if (which >= NRF24_LAT_COUNT){
+        return NRF24_ARG_INVALID;
+    }
+
+#ifdef NRF24_LATENCY
+    *hist = radio->latency[which];
+    return NRF24_OK;
+#else
+    (void)memset(hist, 0, sizeof(*hist));
+    return NRF24_ERROR;
+#endif
+};
+
+nrf24_status_t nRF24_resetHistograms(nrf24_t *radio){
+    if (radio == NULL){
+        return NRF24_NULL_POINTER;
+    }
+
+#ifdef NRF24_LATENCY
+    (void)memset(radio->latency, 0, sizeof(radio->latency));
+    return NRF24_OK;
+#else
+    return NRF24_ERROR;
+#endif
+};
+
+/**
+ * @brief The latency below which percent of the samples fall. 
+ * 
+ * Resolution is the bucket, the upper bound of the bucket that holds the sample is returned 
+ *  (at most the max sample). So 130 us reads as 255 us. 
+ * 
+ * @param percent: 0..100, e.g. 50 for the median or 99 for the tail. 
+ * @param us: The latency in microseconds, 0 without samples. 
+ * @return nrf24_status_t 
+ */
+nrf24_status_t nRF24_histogramPercentile(const nrf24_histogram_t *hist, uint8_t percent, uint32_t *us){
+    uint64_t rank   = 0u;
+    uint64_t seen   = 0u;
+    uint8_t  bucket = 0u;
+
+    if ((hist == NULL) || (us == NULL)){
+        return NRF24_NULL_POINTER;
+    } else if (percent > 100u){
+        return NRF24_ARG_INVALID;
+    }
+
+    *us = 0u;
+    if (hist->count == 0u){
+        return NRF24_OK;
+    }
+
+    /* The rank of the sample, rounded up and at least the first. */
+    rank = (((uint64_t)hist->count * percent) + 99u) / 100u;
+    if (rank == 0u){
+        rank = 1u;
+    }
+
+    for (bucket = 0u; bucket < NRF24_HIST_BUCKETS; ++bucket){
+        seen += hist->buckets[bucket];
+        if (seen >= rank){
+            break;
+        }
+    }
+
+    if (bucket >= (NRF24_HIST_BUCKETS - 1u)){
+        *us = hist->max;
+    } else {
+        *us = rf24_min((uint32_t)((1ull << bucket) - 1u), hist->max);
+    }
+    return NRF24_OK;
+};
+
+/**
+ * @brief Copy the trace ring out, oldest entry first. Requires NRF24_TRACE. 
+ * 
+ * The trace is frozen by the first error (nrf24_trace_op_t NRF24_TRACE_ERROR), it then holds 
+ *  the NRF24_TRACE_DEPTH transactions that led up to it until nRF24_traceClear. 
+ * 
+ * @param entries: Room for max entries. 
+ * @param count: The number of entries copied. 
+ * @return nrf24_status_t: NRF24_ERROR when built without NRF24_TRACE. 
+ */
+nrf24_status_t nRF24_traceRead(nrf24_t *radio, nrf24_trace_entry_t *entries, size_t max, size_t *count){
+    if ((radio == NULL) || (count == NULL) || ((entries == NULL) && (max > 0u))){
+        return NRF24_NULL_POINTER;
+    }
+    *count = 0u;
+
+#ifdef NRF24_TRACE
+    uint32_t first = 0u;
+    size_t   idx   = 0u;
+
+    if (radio->trace_count > NRF24_TRACE_DEPTH){
+        first = radio->trace_count - NRF24_TRACE_DEPTH;
+    }
+
+    /* Keep the newest max entries. */
+    if ((radio->trace_count - first) > max){
+        first = radio->trace_count - (uint32_t)max;
+    }
+
+    for (idx = 0u; (first + idx) != radio->trace_count; ++idx){
+        entries[idx] = radio->trace[(first + idx) & (NRF24_TRACE_DEPTH - 1u)];
+    }
+    *count = idx;
+
+    return NRF24_OK;
+#else
+    (void)entries;
+    (void)max;
+    return NRF24_ERROR;
+#endif
+};
+
+/* Stop recording, to keep the current trace. nRF24_traceClear starts recording again. */
+nrf24_status_t nRF24_traceFreeze(nrf24_t *radio){
+    if (radio == NULL){
+        return NRF24_NULL_POINTER;
+    }
+#ifdef NRF24_TRACE
+    radio->trace_frozen = true;
+    return NRF24_OK;
+#else
+    return NRF24_ERROR;
+#endif
+};
+
+/* Empty the trace and record again, also after it was frozen by an error. */
+nrf24_status_t nRF24_traceClear(nrf24_t *radio){
+    if (radio == NULL){
+        return NRF24_NULL_POINTER;
+    }
+#ifdef NRF24_TRACE
+    radio->trace_count  = 0u;
+    radio->trace_frozen = false;
+    return NRF24_OK;
+#else
+    return NRF24_ERROR;
+#endif
+};
+
+/**
+ * @brief Decode the trace with printf, oldest entry first. Not for the hot path, call it 
+ *  once something failed. 
+ * 
+ * @example
+ *  [nRF24] trace: 3 entries (frozen)
+ *  [nRF24]   1042310 +    0 us  W_TX_PAYLOAD        32 bytes         status 0E
+ *  [nRF24]   1042331 +   21 us  CE HIGH                              status 0E
+ *  [nRF24]   1051377 + 9046 us  ERROR TIMEOUT                        status 0F
+ * 
+ * @return nrf24_status_t: NRF24_ERROR when built without NRF24_TRACE. 
+ */
+nrf24_status_t nRF24_traceDump(nrf24_t *radio){
+    if (radio == NULL){
+        return NRF24_NULL_POINTER;
+    }
+
+#ifdef NRF24_TRACE
+    nrf24_trace_entry_t entries[NRF24_TRACE_DEPTH];
+    size_t              count    = 0u;
+    size_t              idx      = 0u;
+    uint32_t            previous = 0u;
+    char                what[40u];
+
+    (void)nRF24_traceRead(radio, entries, NRF24_TRACE_DEPTH, &count);
+    (void)printf("[nRF24] trace: %u entries%s\r\n", (unsigned)count, radio->trace_frozen ? " (frozen)" : "");
+
+    for (idx = 0u; idx < count; ++idx){
+        const nrf24_trace_entry_t *entry = &entries[idx];
+
+        if (idx == 0u){
+            previous = entry->timestamp;
+        }
+
+        _traceDescribe(entry, what, sizeof(what));
+        (void)printf("[nRF24] %9lu +%5lu us  %-32s status %02X\r\n", (unsigned long)entry->timestamp,
+            (unsigned long)(entry->timestamp - previous), what, entry->status);
+        previous = entry->timestamp;
+    }
+    return NRF24_OK;
+#else
+    return NRF24_ERROR;
+#endif
+};
+
 
 /* Static Functions */
 
-static nrf24_status_t _initRadio() {
-    // nrf24_status_t status = NRF24_OK; 
+static nrf24_status_t _initRadio(nrf24_t *radio, const nrf24_reg_write_t *image, size_t count) {
+    nrf24_status_t status = NRF24_OK; 
+    uint8_t        config = 0u;
+    uint8_t        rate   = 0u;
+    size_t         idx    = 0u;
 
     /* Sleep 5 ms to allow the radio to settle. */
     machine->sleep.ms(5u);
 
-    /* Set retries: Delay 5 ms, Retries: 15 */
-    (void)nRF24_setRetries(5u, 15u);
+    /* Keep the bus for the whole init sequence. */
+    (void)nRF24_acquireBus(radio);
 
-    /* Set Datarate: 1MBPS */
-    (void)nRF24_setDataRate(NRF24_1MBPS);    
+    /* Load the register shadow with the current (reset) values of the chip. */
+    (void)nRF24_syncRegisters(radio);
 
     uint8_t before_toggle; 
-    (void)_readRegister(FEATURE, &before_toggle);
+    (void)_readRegister(radio, FEATURE, &before_toggle);
 
     /* Toggle features */
-    (void)_toggleFeatures();
+    (void)_toggleFeatures(radio);
 
     uint8_t after_toggle;
-    (void)_readRegister(FEATURE, &after_toggle);
+    (void)_readRegister(radio, FEATURE, &after_toggle);
 
-    printf("[nRF24] _initRadio: FEATURE before toggle: 0x%02X\r\n", before_toggle);
-    printf("[nRF24] _initRadio: FEATURE after_toggle: 0x%02X\r\n", after_toggle);
-
-    _is_p_variant = before_toggle == after_toggle;
+    radio->is_p_variant = before_toggle == after_toggle;
     if (after_toggle) {
-        if (_is_p_variant) {
+        if (radio->is_p_variant) {
             // module did not experience power-on-reset (#401)
-            (void)_toggleFeatures();
+            (void)_toggleFeatures(radio);
         }
         // allow use of multicast parameter and dynamic payloads by default
-        (void)_writeRegister(FEATURE, 0u);
+        (void)_writeRegister(radio, FEATURE, 0u);
     }
 
-    /* Disable dynamic payloads by default (for all pipes) */
-    (void)nRF24_setDynamicPayloadLength(false);
-
-    /* Enable Auto-Ack on all Pipes */
-    (void)nRF24_setAutoAck(true);
-
     /* Only open RX pipe 0 & 1 */
-    (void)_writeRegister(EN_RXADDR, 3u);
-
-    (void)nRF24_setPayloadSize(NRF24_MAX_PAYLOAD_SIZE);
-    (void)nRF24_setAddressWidth(5u);
+    (void)_writeRegister(radio, EN_RXADDR, 3u);
 
-    (void)nRF24_setChannel(76u);
+    /* Commit the whole configuration, only the registers that differ from reset are written. */
+    if (image == NULL){
+        status = nRF24_applyConfig(radio, &radio->cfg);
+    } else {
+        for (idx = 0u; (idx < count) && (status == NRF24_OK); ++idx) {
+            if ((image[idx].reg >= NRF24_REG_COUNT) || (image[idx].reg == NRF_STATUS)){
+                status = NRF24_ARG_INVALID;
+            } else if (image[idx].value != radio->regs[image[idx].reg]){
+                _batchWrite(radio, image[idx].reg, &image[idx].value, 1u);
+            }
+        }
+        _batchSubmit(radio);
+        /* Only for the txDelay, the RF_SETUP bits are part of the image. */
+        (void)_dataRateConversion(radio, radio->cfg.datarate, &rate);
+    }
 
     /*  Reset current status. 
         Notice reset 
     */
-    (void)_writeRegister(NRF_STATUS, NRF24_IRQ_ALL);
+    (void)_writeRegister(radio, NRF_STATUS, NRF24_IRQ_ALL);
 
     /* And Flush rx/tx fifo buffers*/
-    (void)nRF24_flushRx();
-    (void)nRF24_flushTx();
-
+    (void)nRF24_flushRx(radio);
+    (void)nRF24_flushTx(radio);
 
-    (void)nRF24_setCrcLength(NRF24_CRC_16);
-    (void)_readRegister(NRF_CONFIG, &config_reg);
+    (void)nRF24_powerUp(radio);
 
-    (void)nRF24_powerUp();
+    /* Read CONFIG back once, to check that the chip actually took the configuration. */
+    (void)_readRegister(radio, NRF_CONFIG, &config);
     
-    #ifdef NRF24_DEBUG
-    (void)printf("[NRF24] - config_req after powerup: %02x (%c%c%c%c %c%c%c%c) status: %02X\r\n", config_reg,
-        (config_reg & 0x80) ? '1' : '0',
-        (config_reg & 0x40) ? '1' : '0',
-        (config_reg & 0x20) ? '1' : '0',
-        (config_reg & 0x10) ? '1' : '0',
-        (config_reg & 0x08) ? '1' : '0',
-        (config_reg & 0x04) ? '1' : '0',
-        (config_reg & 0x02) ? '1' : '0',
-        (config_reg & 0x01) ? '1' : '0',
-        nrf24_spi_status
-    );
-    #endif 
     
     /* Mask the wanted bits. bit 0 indicates PTX or PRX. Ignore.  */
-    return ((config_reg & 0b1110) == (_BV(EN_CRC) | _BV(CRCO) | _BV(PWR_UP))) ? NRF24_OK : NRF24_ERROR;
+    if ((status == NRF24_OK) && ((config & 0b1110) != (radio->regs[NRF_CONFIG] & 0b1110))) {
+        status = NRF24_ERROR;
+    }
+
+    (void)nRF24_releaseBus(radio);
+    return status;
 }
 
-static nrf24_status_t _toggleFeatures(void){
+/* Translate a nrf24_cfg_t into the register values it needs, on top of the current shadow. 
+    Mirrors the setters: ackPayloads need dynamicPayloads, and dynamicPayloads need autoAck. 
+ */
+static nrf24_status_t _buildImage(nrf24_t *radio, const nrf24_cfg_t *cfg, uint8_t *image){
+    nrf24_status_t status   = NRF24_OK; 
+    uint8_t        idx      = 0u;
+    uint8_t        rate     = 0u;
+    bool           dynamic  = cfg->dynamicPayloads || cfg->ack.ackPayload;
+    bool           autoAck  = cfg->ack.autoAck || dynamic;
+
+    if ((cfg->addressWidth < NRF24_MIN_ADDRESS_WIDTH) || (cfg->addressWidth > NRF24_MAX_ADDRESS_WIDTH) ||
+        (cfg->payloadSize > NRF24_MAX_PAYLOAD_SIZE) || (cfg->channel > NRF24_MAX_RF_CHANNEL) ||
+        (cfg->datarate >= NRF24_MAX_RATE) || (cfg->crc >= NRF24_CRC_ERROR) ||
+        (cfg->retries.delay > 15u) || (cfg->retries.count > 15u) || (cfg->PA.level >= NRF24_PA_ERROR)) {
+        status = NRF24_ARG_INVALID;
+    } else {
+        (void)memcpy(image, radio->regs, NRF24_REG_COUNT);
+        (void)_dataRateConversion(radio, cfg->datarate, &rate);
+
+        image[SETUP_AW]   = (uint8_t)(cfg->addressWidth - 2u);
+        image[SETUP_RETR] = (uint8_t)((cfg->retries.delay << 4u) | cfg->retries.count);
+        image[RF_CH]      = cfg->channel;
+        image[RF_SETUP]   = (uint8_t)((image[RF_SETUP] & ~(_BV(RF_DR_LOW) | _BV(RF_DR_HIGH) | 0x07)) | 
+                                rate | (cfg->PA.level << 1u) | cfg->PA.lnaEnabled);
+        image[FEATURE]    = (uint8_t)((dynamic ? _BV(EN_DPL) : 0u) | 
+                                (cfg->ack.ackPayload ? _BV(EN_ACK_PAY) : 0u) | 
+                                (cfg->ack.dynamicAck ? _BV(EN_DYN_ACK) : 0u));
+        image[DYNPD]      = dynamic ? 0x3F : 0u;
+        image[EN_AA]      = autoAck ? 0x3F : 0u;
+
+        for (idx = 0u; idx < 6u; ++idx) {
+            image[RX_PW_P0 + idx] = cfg->payloadSize;
+        }
+
+        image[NRF_CONFIG] &= ~(_BV(CRCO) | _BV(EN_CRC));
+        if (cfg->crc == NRF24_CRC_8){
+            image[NRF_CONFIG] |= _BV(EN_CRC);
+        } else if (cfg->crc == NRF24_CRC_16){
+            image[NRF_CONFIG] |= (_BV(CRCO) | _BV(EN_CRC));
+        }
+    }
+
+    return status;
+}
+
+static nrf24_status_t _toggleFeatures(nrf24_t *radio){
     nrf24_status_t status = NRF24_OK;
 
-    (void)_beginTransaction();
+    (void)_beginTransaction(radio);
 
     uint8_t tx[2u] = {ACTIVATE, 0x73}; 
     uint8_t rx[2u];
 
-    (void)machine->spi.transfer(_spi, (const uint8_t *)&tx, (uint8_t *)&rx, sizeof(tx));
+    (void)_transfer(radio, (const uint8_t *)&tx, (uint8_t *)&rx, sizeof(tx));
     
     /* Stop compiler error -unused-variable */
     (void)rx;
 
-    (void)_endTransaction();
+    (void)_endTransaction(radio);
+    TRACE(radio, NRF24_TRACE_WRITE_NB, ACTIVATE, 0x73);
 
     return status;
 }
 
 
-static nrf24_status_t _readRegister(uint8_t reg, uint8_t *result){
+static nrf24_status_t _readRegister(nrf24_t *radio, uint8_t reg, uint8_t *result){
     nrf24_status_t status = NRF24_OK;
 
-    #ifdef NRF24_DEBUG
-    (void)printf("[NRF24] - _readRegister(%02x) -> ", reg);
-    #endif 
-
-    (void)_beginTransaction();
+    (void)_beginTransaction(radio);
 
-    uint8_t* prx = rx_buffer;
-    uint8_t* ptx = tx_buffer;
+    uint8_t* prx = radio->rx_buffer;
+    uint8_t* ptx = radio->tx_buffer;
     *ptx++ = reg;
     *ptx++ = RF24_NOP; // Dummy operation, just for reading
 
-    machine->spi.transfer(_spi, (const uint8_t*)tx_buffer, rx_buffer, 2u);
+    _transfer(radio, (const uint8_t*)radio->tx_buffer, radio->rx_buffer, 2u);
 
-    nrf24_spi_status = *prx;   // status is 1st byte of receive buffer
+    radio->spi_status = *prx;   // status is 1st byte of receive buffer
     *result = *++prx; // result is 2nd byte of receive buffer
 
-    (void)_endTransaction();
-
-    #ifdef NRF24_DEBUG
-    (void)printf("%02x (%c%c%c%c %c%c%c%c) status: %02X\r\n", *result,
-        (*result & 0x80) ? '1' : '0',
-        (*result & 0x40) ? '1' : '0',
-        (*result & 0x20) ? '1' : '0',
-        (*result & 0x10) ? '1' : '0',
-        (*result & 0x08) ? '1' : '0',
-        (*result & 0x04) ? '1' : '0',
-        (*result & 0x02) ? '1' : '0',
-        (*result & 0x01) ? '1' : '0',
-        nrf24_spi_status
-    );
-    #endif 
+    (void)_endTransaction(radio);
+
+    if (reg == FIFO_STATUS){
+        if ((*result & _BV(RX_FULL)) && !radio->rx_was_full){
+            radio->stats.rx_full++;
+        }
+        radio->rx_was_full = ((*result & _BV(RX_FULL)) != 0u);
+    }
+
+    TRACE(radio, NRF24_TRACE_READ, reg, *result);
 
     return status;
 };
 
 
-static nrf24_status_t _readRegisternb(uint8_t reg, uint8_t *buffer, size_t length) {
+static nrf24_status_t _readRegisternb(nrf24_t *radio, uint8_t reg, uint8_t *buffer, size_t length) {
     nrf24_status_t status = NRF24_OK;
     
-    #ifdef NRF24_DEBUG
-    (void)printf("[NRF24] - _readRegisternb(%02X, buff, %d)\r\n", reg, length);
-    #endif 
-
-    (void)_beginTransaction();
+    (void)_beginTransaction(radio);
     
-    uint8_t* prx = rx_buffer;
-    uint8_t* ptx = tx_buffer;
+    uint8_t* prx = radio->rx_buffer;
+    uint8_t* ptx = radio->tx_buffer;
     uint8_t size = (uint8_t)(length + 1u);
 
     *ptx++ = reg;
@@ -794,53 +2101,170 @@ static nrf24_status_t _readRegisternb(uint8_t reg, uint8_t *buffer, size_t lengt
         *ptx++ = RF24_NOP; // Dummy operation, just for reading
     }
 
-    machine->spi.transfer(_spi, (const uint8_t *)tx_buffer, rx_buffer, size);
+    _transfer(radio, (const uint8_t *)radio->tx_buffer, radio->rx_buffer, size);
 
-    nrf24_spi_status = *prx++;
+    radio->spi_status = *prx++;
  
     while (--size) {
         *buffer++ = *prx++;
     }
 
-    (void)_endTransaction();
+    (void)_endTransaction(radio);
+    /* prx only moved past the status byte when bytes were read, commands trace 0. */
+    TRACE(radio, NRF24_TRACE_READ_NB, reg, (prx > &radio->rx_buffer[1u]) ? radio->rx_buffer[1u] : 0u);
 
     return status;
 };
 
 
-static nrf24_status_t _writeRegister(uint8_t reg, const uint8_t value){
+static nrf24_status_t _writeRegister(nrf24_t *radio, uint8_t reg, const uint8_t value){
     nrf24_status_t status = NRF24_OK; 
     
-    #ifdef NRF24_DEBUG
-    (void)printf("[NRF24] - _writeRegister(%02X,%02X)\r\n", reg, value);
-    #endif
+    (void)_beginTransaction(radio);
 
-    (void)_beginTransaction();
-
-    uint8_t* prx = rx_buffer;
-    uint8_t* ptx = tx_buffer;
+    uint8_t* prx = radio->rx_buffer;
+    uint8_t* ptx = radio->tx_buffer;
     *ptx++ = (W_REGISTER | reg);
     *ptx = value;
 
-    machine->spi.transfer(_spi, (const uint8_t *)tx_buffer, rx_buffer, 2);
+    _transfer(radio, (const uint8_t *)radio->tx_buffer, radio->rx_buffer, 2);
     
-    nrf24_spi_status = *prx; 
+    radio->spi_status = *prx; 
+
+    (void)_endTransaction(radio);
+    TRACE(radio, NRF24_TRACE_WRITE, reg, value);
 
-    (void)_endTransaction();
+    _onRegisterWrite(radio, reg, value);
     return status;
 };
 
+/* Bookkeeping of a register write, after it was clocked out with radio->spi_status. */
+static void _onRegisterWrite(nrf24_t *radio, uint8_t reg, uint8_t value){
+    /* STATUS is write 1 to clear, so it has no shadow. The status byte clocked out holds 
+        the flags that were set, count the events that this write clears. */
+    if (reg == NRF_STATUS){
+        if (radio->spi_status & value & NRF24_TX_DS){
+            radio->stats.tx_ok++;
+#ifdef NRF24_LATENCY
+            if (radio->lat_tx_pending){
+                _latency(radio, NRF24_LAT_TX, radio->lat_tx_at);
+            }
+#endif
+        }
+        if (radio->spi_status & value & NRF24_TX_DF){
+            radio->stats.tx_max_rt++;
+            radio->stats.retransmits += radio->cfg.retries.count;
+        }
+#ifdef NRF24_LATENCY
+        if (radio->spi_status & value & (NRF24_TX_DS | NRF24_TX_DF)){
+            radio->lat_tx_pending = false;
+        }
+#endif
+    } else if (reg < NRF24_REG_COUNT){
+        radio->regs[reg] = value;
+    }
+
+    /* Writing RF_CH resets PLOS_CNT. */
+    if (reg == RF_CH){
+        radio->plos_seen = 0u;
+    }
+}
+
+/* Queue a register write for _batchSubmit, a full queue is submitted first. The address 
+    shadows follow right away, the rest of the bookkeeping once it is clocked out. */
+static void _batchWrite(nrf24_t *radio, uint8_t reg, const uint8_t *buffer, uint8_t length){
+    uint8_t *shadow = NULL;
+    uint8_t *ptx    = NULL;
+    uint8_t  slot   = 0u;
+
+    length = rf24_min(length, NRF24_MAX_ADDRESS_WIDTH);
+    if (radio->batch_count == NRF24_BATCH_DEPTH){
+        _batchSubmit(radio);
+    }
+
+    if ((shadow = _shadowAddress(radio, reg)) != NULL){
+        (void)memcpy(shadow, buffer, length);
+    }
+
+    slot   = radio->batch_count++;
+    ptx    = radio->batch_tx[slot];
+    *ptx++ = (W_REGISTER | reg);
+    (void)memcpy(ptx, buffer, length);
+
+    radio->batch[slot] = (spi_segment_t){ .tx = radio->batch_tx[slot], .rx = radio->batch_rx[slot], .len = length + 1u };
+}
+
+/* Queue a shadowed register write only when the value differs from the shadow. */
+static void _batchUpdate(nrf24_t *radio, uint8_t reg, uint8_t value){
+    if (radio->regs[reg] != value){
+        _batchWrite(radio, reg, &value, 1u);
+    }
+}
+
+/* Send the queued writes. One machine->spi.batch call when the backend owns CSN, else 
+    a transaction per write. radio->spi_status ends up as the status of the last one. */
+static void _batchSubmit(nrf24_t *radio){
+    size_t  idx   = 0u;
+    uint8_t reg   = 0u;
+#ifdef NRF24_LATENCY
+    uint32_t start = 0u;
+#endif
+
+    if (radio->batch_count == 0u){
+        return;
+    }
+
+    (void)nRF24_acquireBus(radio);
+    if (radio->hw_cs && (machine->spi.batch != NULL)){
+#ifdef NRF24_LATENCY
+        start = machine->time.micros();
+#endif
+        (void)machine->spi.batch(radio->spi, radio->batch, radio->batch_count);
+        radio->stats.spi_transactions += radio->batch_count;
+        for (idx = 0u; idx < radio->batch_count; ++idx){
+            radio->stats.spi_bytes += (uint32_t)radio->batch[idx].len;
+        }
+#ifdef NRF24_LATENCY
+        _latency(radio, NRF24_LAT_SPI, start);
+#endif
+    } else {
+        for (idx = 0u; idx < radio->batch_count; ++idx){
+            (void)_beginTransaction(radio);
+            _transfer(radio, radio->batch[idx].tx, radio->batch[idx].rx, radio->batch[idx].len);
+            (void)_endTransaction(radio);
+        }
+    }
+    (void)nRF24_releaseBus(radio);
+
+    for (idx = 0u; idx < radio->batch_count; ++idx){
+        reg               = (uint8_t)(radio->batch_tx[idx][0u] & ~W_REGISTER);
+        radio->spi_status = radio->batch_rx[idx][0u];
+
+        if (_shadowAddress(radio, reg) != NULL){
+            TRACE(radio, NRF24_TRACE_WRITE_NB, reg, radio->batch_tx[idx][1u]);
+        } else {
+            TRACE(radio, NRF24_TRACE_WRITE, reg, radio->batch_tx[idx][1u]);
+            _onRegisterWrite(radio, reg, radio->batch_tx[idx][1u]);
+        }
+    }
+    radio->batch_count = 0u;
+}
+
 
-static nrf24_status_t _writeRegisternb(uint8_t reg, const uint8_t* buffer, uint8_t length){
+static nrf24_status_t _writeRegisternb(nrf24_t *radio, uint8_t reg, const uint8_t* buffer, uint8_t length){
     nrf24_status_t status = NRF24_OK;
+    uint8_t       *shadow = NULL;
 
-    #ifdef NRF24_DEBUG
-    (void)printf("[NRF24] - _writeRegisternb(%02X, buff, %d)\r\n", reg, length);
-    #endif 
+    /* Keep the shadow in sync, pipe 2-5 only have their LSB written. */
+    if ((shadow = _shadowAddress(radio, reg)) != NULL){
+        (void)memcpy(shadow, buffer, rf24_min(length, NRF24_MAX_ADDRESS_WIDTH));
+    } else if ((reg < NRF24_REG_COUNT) && (length > 0u)){
+        radio->regs[reg] = *buffer;
+    }
 
-    (void)_beginTransaction();
-    uint8_t* prx = rx_buffer;
-    uint8_t* ptx = tx_buffer;
+    (void)_beginTransaction(radio);
+    uint8_t* prx = radio->rx_buffer;
+    uint8_t* ptx = radio->tx_buffer;
     uint8_t size = (uint8_t)(length + 1u); // Add register value to transmit buffer
 
     *ptx++ = (W_REGISTER | reg);
@@ -848,16 +2272,17 @@ static nrf24_status_t _writeRegisternb(uint8_t reg, const uint8_t* buffer, uint8
         *ptx++ = *buffer++;
     }
 
-    machine->spi.transfer(_spi, (const uint8_t *)tx_buffer, rx_buffer, size);
+    _transfer(radio, (const uint8_t *)radio->tx_buffer, radio->rx_buffer, size);
 
-    nrf24_spi_status = *prx; // status is 1st byte of receive buffer
-    (void)_endTransaction();
+    radio->spi_status = *prx; // status is 1st byte of receive buffer
+    (void)_endTransaction(radio);
+    TRACE(radio, NRF24_TRACE_WRITE_NB, reg, radio->tx_buffer[1u]);
 
     return status;
 };
 
 
-static nrf24_status_t _writePayload(const void *buffer, uint8_t length, const bool multicast){
+static nrf24_status_t _writePayload(nrf24_t *radio, const void *buffer, uint8_t length, uint8_t command){
     nrf24_status_t status = NRF24_OK; 
 
     const uint8_t *current = (const uint8_t *)buffer;  
@@ -867,50 +2292,60 @@ static nrf24_status_t _writePayload(const void *buffer, uint8_t length, const bo
         return NRF24_ARG_INVALID;
     } 
 
-    if (!_cfg->dynamicPayloads) {
-        length = rf24_min(length, _cfg->payloadSize);
-        blank_len = (_cfg->payloadSize - length);
+    if (!radio->cfg.dynamicPayloads) {
+        length = rf24_min(length, radio->cfg.payloadSize);
+        blank_len = (radio->cfg.payloadSize - length);
     }
     else {
         length = rf24_min(length, NRF24_MAX_PAYLOAD_SIZE);
     }
 
-    #ifdef NRF24_DEBUG
-    printf("[NRF24] - _writePayload(Writing %u bytes %u blanks)\r\n", length, blank_len);
-    #endif 
-
-    _beginTransaction();
-    uint8_t* prx = rx_buffer;
-    uint8_t* ptx = tx_buffer;
+    _beginTransaction(radio);
+    uint8_t* prx = radio->rx_buffer;
+    uint8_t* ptx = radio->tx_buffer;
     uint8_t size;
     size = (length + blank_len + 1u); // Add register value to transmit buffer
 
-    if (multicast){
-        *ptx++ = W_TX_PAYLOAD_NO_ACK;
-    } else{
-        *ptx++ = W_TX_PAYLOAD;
-    }
+    *ptx++ = command;
 
-    while (length--) {
-        *ptx++ = *current++;
-    }
+    if (machine->spi.transferv != NULL) {
+        /* Send the payload straight from the caller's buffer. */
+        spi_segment_t segments[3u];
+        size_t        count = 0u;
+
+        segments[count++] = (spi_segment_t){ .tx = radio->tx_buffer, .rx = radio->rx_buffer, .len = 1u };
+        if (length > 0u) {
+            segments[count++] = (spi_segment_t){ .tx = current, .rx = NULL, .len = length };
+        }
+        if (blank_len > 0u) {
+            segments[count++] = (spi_segment_t){ .tx = blank_bytes, .rx = NULL, .len = blank_len };
+        }
+        (void)_transferv(radio, segments, count);
 
-    while (blank_len--) {
-        *ptx++ = 0u;
+        radio->spi_status = *prx;
+        (void)_endTransaction(radio);
+        TRACE(radio, NRF24_TRACE_TX_PAYLOAD, radio->tx_buffer[0u], length);
+        return status;
     }
 
-    (void)machine->spi.transfer(_spi, tx_buffer, rx_buffer, size);
+    /* length and blank_len stay intact for the trace. */
+    (void)memcpy(ptx, current, length);
+    (void)memset(&ptx[length], 0, blank_len);
+
+    (void)_transfer(radio, radio->tx_buffer, radio->rx_buffer, size);
     
-    nrf24_spi_status = *prx++;
+    radio->spi_status = *prx++;
 
-    (void)_endTransaction();
+    (void)_endTransaction(radio);
+    TRACE(radio, NRF24_TRACE_TX_PAYLOAD, radio->tx_buffer[0u], length);
 
     return status; 
 };
 
-static nrf24_status_t _readPayload(void *buffer, uint8_t length){
+static nrf24_status_t _readPayload(nrf24_t *radio, void *buffer, uint8_t length, uint8_t *received){
     nrf24_status_t status = NRF24_OK; 
     uint8_t blank_len = 0u;
+    uint8_t width     = 0u;
 
     uint8_t *current = (uint8_t *)buffer;  
 
@@ -918,105 +2353,464 @@ static nrf24_status_t _readPayload(void *buffer, uint8_t length){
         return NRF24_ARG_INVALID;
     } 
 
-    if (!_cfg->dynamicPayloads) {
-        length = rf24_min(length, _cfg->payloadSize);
-        blank_len = (_cfg->payloadSize - length);
+    if (!radio->cfg.dynamicPayloads) {
+        length = rf24_min(length, radio->cfg.payloadSize);
+        blank_len = (radio->cfg.payloadSize - length);
+    }
+    else if ((status = nRF24_getDynamicPayloadSize(radio, &width)) != NRF24_OK) {
+        /* Corrupt width, the RX FIFO is flushed. */
+        return status;
     }
     else {
-        length = rf24_min(length, NRF24_MAX_PAYLOAD_SIZE);
+        /* Only clock the bytes that were on air. */
+        length = rf24_min(length, width);
     }
 
-    (void)_beginTransaction();
+    if (received != NULL){
+        *received = length;
+    }
+
+    (void)_beginTransaction(radio);
 
-    uint8_t* prx = rx_buffer;
-    uint8_t* ptx = tx_buffer;
+    uint8_t* prx = radio->rx_buffer;
+    uint8_t* ptx = radio->tx_buffer;
 
     uint8_t size = (length + blank_len + 1u); // Add register value to transmit buffer
 
     *ptx++ = R_RX_PAYLOAD;
-    while (--size) {
-        *ptx++ = RF24_NOP;
-    }
 
-    size = (length + blank_len + 1u); // Size has been lost during while, re affect
+    if (machine->spi.transferv != NULL) {
+        /* Clock the payload straight into the caller's buffer. */
+        spi_segment_t segments[3u];
+        size_t        count = 0u;
 
-    machine->spi.transfer(_spi, tx_buffer, rx_buffer, size);
-
-    nrf24_spi_status = *prx++; // 1st byte is status
-
-    if (length > 0u) {
-        // Decrement before to skip 1st status byte
-        while (--length) {
-            *current++ = *prx++;
+        segments[count++] = (spi_segment_t){ .tx = radio->tx_buffer, .rx = radio->rx_buffer, .len = 1u };
+        if (length > 0u) {
+            segments[count++] = (spi_segment_t){ .tx = blank_bytes, .rx = current, .len = length };
         }
+        if (blank_len > 0u) {
+            segments[count++] = (spi_segment_t){ .tx = blank_bytes, .rx = NULL, .len = blank_len };
+        }
+        (void)_transferv(radio, segments, count);
 
-        *current = *prx;
+        radio->spi_status = *prx;
+        (void)_endTransaction(radio);
+        _onRxPayload(radio);
+        TRACE(radio, NRF24_TRACE_RX_PAYLOAD, R_RX_PAYLOAD, length);
+        return status;
     }
 
-    (void)_endTransaction();
+    /* length stays intact for the trace. */
+    (void)memset(ptx, RF24_NOP, (size_t)size - 1u);
+
+    _transfer(radio, radio->tx_buffer, radio->rx_buffer, size);
+
+    radio->spi_status = *prx++; // 1st byte is status
+    (void)memcpy(current, prx, length);
+
+    (void)_endTransaction(radio);
+    _onRxPayload(radio);
+    TRACE(radio, NRF24_TRACE_RX_PAYLOAD, R_RX_PAYLOAD, length);
     
     return status; 
 };
 
-static nrf24_status_t _beginTransaction() {
-    (void)machine->spi.beginTransaction(_spi);
-    (void)csn(LOW);
+static nrf24_status_t _beginTransaction(nrf24_t *radio) {
+    (void)nRF24_acquireBus(radio);
+#ifdef NRF24_LATENCY
+    radio->lat_txn_at = machine->time.micros();
+#endif
+    (void)csn(radio, LOW);
+    radio->stats.spi_transactions++;
     return NRF24_OK;
 }
 
-static nrf24_status_t _endTransaction() {
-    (void)csn(HIGH);
-    (void)machine->spi.endTransaction(_spi);
+static nrf24_status_t _endTransaction(nrf24_t *radio) {
+    (void)csn(radio, HIGH);
+#ifdef NRF24_LATENCY
+    _latency(radio, NRF24_LAT_TRANSACTION, radio->lat_txn_at);
+#endif
+    (void)nRF24_releaseBus(radio);
     return NRF24_OK;
 }
 
-static uint8_t _updateStatus(void){
-    (void)_readRegisternb(RF24_NOP, NULL, 0);
-    return nrf24_spi_status;
+/* Every transfer of the driver goes through these two, they keep stats.spi_bytes. */
+static void _transfer(nrf24_t *radio, const uint8_t *tx, uint8_t *rx, size_t len){
+#ifdef NRF24_LATENCY
+    uint32_t start = machine->time.micros();
+#endif
+
+    (void)machine->spi.transfer(radio->spi, tx, rx, len);
+    radio->stats.spi_bytes += (uint32_t)len;
+
+#ifdef NRF24_LATENCY
+    _latency(radio, NRF24_LAT_SPI, start);
+#endif
+}
+
+static void _transferv(nrf24_t *radio, const spi_segment_t *segments, size_t count){
+    size_t idx = 0u;
+#ifdef NRF24_LATENCY
+    uint32_t start = machine->time.micros();
+#endif
+
+    (void)machine->spi.transferv(radio->spi, segments, count);
+    for (idx = 0u; idx < count; ++idx){
+        radio->stats.spi_bytes += (uint32_t)segments[idx].len;
+    }
+
+#ifdef NRF24_LATENCY
+    _latency(radio, NRF24_LAT_SPI, start);
+#endif
+}
+
+static uint8_t _updateStatus(nrf24_t *radio){
+    (void)_readRegisternb(radio, RF24_NOP, NULL, 0);
+    return radio->spi_status;
 }
 
-static void _dataRateConversion(nrf24_datarate_t rate, uint8_t *bits){
+/* Bookkeeping of every payload read. The status byte of R_RX_PAYLOAD holds its pipe (RX_P_NO). */
+static void _onRxPayload(nrf24_t *radio){
+    uint8_t pipe = (uint8_t)((radio->spi_status >> RX_P_NO) & 0x07);
+
+    if (pipe <= 5u){
+        radio->stats.rx_payloads[pipe]++;
+    }
+    /* A payload was taken out, the RX FIFO is no longer full. */
+    radio->rx_was_full = false;
+
+#ifdef NRF24_LATENCY
+    if (radio->lat_irq_pending){
+        radio->lat_irq_pending = false;
+        _latency(radio, NRF24_LAT_IRQ, radio->lat_irq_at);
+    }
+    radio->lat_rx_at      = machine->time.micros();
+    radio->lat_rx_pending = true;
+#endif
+}
+
+/* Bookkeeping of every payload loaded by nRF24_write, fastWrite and writeWithAck. */
+static void _onTxPayload(nrf24_t *radio){
+    radio->stats.tx_payloads++;
+
+#ifdef NRF24_LATENCY
+    if (radio->lat_rx_pending){
+        radio->lat_rx_pending = false;
+        _latency(radio, NRF24_LAT_TURNAROUND, radio->lat_rx_at);
+    }
+    /* A TX_DS covers every payload before it, time from the oldest. */
+    if (!radio->lat_tx_pending){
+        radio->lat_tx_at      = machine->time.micros();
+        radio->lat_tx_pending = true;
+    }
+#endif
+}
+
+/* Read OBSERVE_TX and add the packets lost since the last read to stats.lost. Returns ARC_CNT. */
+static uint8_t _observeTx(nrf24_t *radio){
+    uint8_t observe = 0u;
+    uint8_t plos    = 0u;
+
+    (void)_readRegister(radio, OBSERVE_TX, &observe);
+    plos = (uint8_t)(observe >> PLOS_CNT);
+
+    if (plos > radio->plos_seen){
+        radio->stats.lost += (uint32_t)(plos - radio->plos_seen);
+    }
+    radio->plos_seen = plos;
+
+    /* PLOS_CNT stops at 15, writing RF_CH (unchanged) restarts it. */
+    if (plos == 0x0F){
+        (void)_writeRegister(radio, RF_CH, radio->regs[RF_CH]);
+    }
+    return (uint8_t)(observe & 0x0F);
+}
+
+/* Count the payloads in a halted (MAX_RT) TX FIFO by filling it. Flush it afterwards! */
+static uint8_t _countTxQueued(nrf24_t *radio){
+    uint8_t filler = 0u;
+
+    (void)_updateStatus(radio);
+    while (!(radio->spi_status & _BV(TX_FULL)) && (filler < 3u)){
+        (void)_writePayload(radio, &filler, 1u, W_TX_PAYLOAD);
+        filler++;
+        (void)_updateStatus(radio);
+    }
+    return 3u - filler;
+}
+
+static void _dataRateConversion(nrf24_t *radio, nrf24_datarate_t rate, uint8_t *bits){
     if (rate == NRF24_250KBPS) {
 #if !defined(F_CPU) || F_CPU > 20000000
-        txDelay = 505u; 
+        radio->txDelay = 505u; 
 #else /* 16MHZ Arduino */
-        txDelay = 155u; 
+        radio->txDelay = 155u; 
 #endif 
         *bits = (uint8_t)_BV(RF_DR_LOW);
     } 
     
     else if (rate == NRF24_1MBPS) {
 #if !defined(F_CPU) || F_CPU > 20000000
-        txDelay = 280u;
+        radio->txDelay = 280u;
 #else  /* 16MHZ Arduino */
-        txDelay = 85u; 
+        radio->txDelay = 85u; 
 #endif 
         *bits = (uint8_t)0u;
     } 
     
     else if (rate == NRF24_2MBPS) {
 #if !defined(F_CPU) || F_CPU > 20000000
-        txDelay = 240u; 
+        radio->txDelay = 240u; 
 #else /* 16MHZ Arduino */
-        txDelay = 65u; 
+        radio->txDelay = 65u; 
 #endif 
         *bits = (uint8_t)_BV(RF_DR_HIGH);
     }
 
 }; 
 
-static void csn(bool level){
-    if (_cfg != NULL){
-        (void)machine->gpio.write(_cfg->gpio.csn, level);
+/* Falling edge of the IRQ pin, runs in interrupt context so no SPI here. */
+static void _irqHandler(void *arg){
+    nrf24_t *radio = (nrf24_t *)arg;
+
+#ifdef NRF24_LATENCY
+    /* Time from the first edge, until a payload is read. */
+    if (!radio->lat_irq_pending){
+        radio->lat_irq_at      = machine->time.micros();
+        radio->lat_irq_pending = true;
+    }
+#endif
+    radio->irq_pending = true;
+    if (radio->irq_notify != NULL){
+        radio->irq_notify(radio->irq_arg);
+    }
+}
+
+/* Returns a free slot of radio_pool marked in use, or NULL when all are taken. 
+    Lock free, a slot is only handed out by the thread whose compare exchange took it. */
+static nrf24_t *_claimRadio(void){
+    nrf24_t *radio = NULL;
+    bool     taken = false;
+
+    for (size_t i = 0u; (i < NRF24_MAX_INSTANCES) && (radio == NULL); ++i){
+        taken = false;
+        if (atomic_compare_exchange_strong_explicit(&radio_claimed[i], &taken, true, 
+                memory_order_acquire, memory_order_relaxed)){
+            radio = &radio_pool[i];
+        }
+    }
+    return radio;
+}
+
+/* Wipe the slot, then hand it back. The release pairs with the acquire of _claimRadio, 
+    so the next owner never sees the old state. */
+static void _releaseRadio(nrf24_t *radio){
+    size_t idx = (size_t)(radio - radio_pool);
+
+    (void)memset(radio, 0, sizeof(nrf24_t));
+    atomic_store_explicit(&radio_claimed[idx], false, memory_order_release);
+}
+
+/* Returns the shadow of a multi byte address register, or NULL for any other register. */
+static uint8_t *_shadowAddress(nrf24_t *radio, uint8_t reg){
+    uint8_t *shadow = NULL;
+
+    if (reg == RX_ADDR_P0){
+        shadow = radio->rx_addr[0u];
+    } else if (reg == RX_ADDR_P1){
+        shadow = radio->rx_addr[1u];
+    } else if (reg == TX_ADDR){
+        shadow = radio->tx_addr;
+    }
+    return shadow;
+}
+
+/* Hand CSN to the SPI backend when it can drive it, else it is a GPIO written by csn(). */
+static void _setupChipSelect(nrf24_t *radio){
+    radio->hw_cs = (machine->spi.chipSelect != NULL) && 
+                   (machine->spi.chipSelect(radio->spi, radio->cfg.gpio.csn) == 0);
+
+    if (!radio->hw_cs){
+        machine->gpio.config(radio->cfg.gpio.csn, true);
+        (void)csn(radio, HIGH);
+    }
+}
+
+static void csn(nrf24_t *radio, bool level){
+    if ((radio != NULL) && !radio->hw_cs){
+        (void)machine->gpio.write(radio->cfg.gpio.csn, level);
+    }
+}
+
+static void ce(nrf24_t *radio, bool level){
+    int32_t left = 0;
+
+    if (radio == NULL){
+        return;
+    }
+
+    if ((level == HIGH) && !nRF24_isReady(radio)){
+        /* Still in Tpd2stby or a turnaround, only sleep for what is left of it. */
+        left = (int32_t)(radio->ready_at - machine->time.micros());
+        if (left > 0){
+            machine->sleep.us((uint32_t)left);
+        }
+        (void)nRF24_isReady(radio);
+    }
+
+    (void)machine->gpio.write(radio->cfg.gpio.ce, level);
+    TRACE(radio, NRF24_TRACE_CE, 0u, level);
+
+    if (!(radio->regs[NRF_CONFIG] & _BV(PWR_UP))){
+        radio->state = NRF24_STATE_POWER_DOWN;
+    } else if (level == LOW){
+        /* Tpd2stby is not over because CE went low, POWERING_UP ends with its window. */
+        (void)nRF24_isReady(radio);
+        if (radio->state != NRF24_STATE_POWERING_UP){
+            radio->state = NRF24_STATE_STANDBY;
+        }
+    } else if (radio->regs[NRF_CONFIG] & _BV(PRIM_RX)){
+        radio->state         = NRF24_STATE_RX_SETTLING;
+        radio->ready_at      = machine->time.micros() + NRF24_TSTBY2A_US;
+        radio->ready_pending = true;
+    } else {
+        radio->state = NRF24_STATE_TX;
+    }
+}
+
+/* End the current window no earlier than us from now. A later pending deadline (Tpd2stby 
+    after nRF24_powerUp) is kept, so a turnaround never shortens it. */
+static void _readyNotBefore(nrf24_t *radio, uint32_t us){
+    uint32_t deadline = machine->time.micros() + us;
+
+    if (!nRF24_isReady(radio) && ((int32_t)(deadline - radio->ready_at) <= 0)){
+        return;
     }
+    radio->ready_at      = deadline;
+    radio->ready_pending = true;
 }
 
-static void ce(bool level){
-    if (_cfg != NULL){
-        (void)machine->gpio.write(_cfg->gpio.ce, level);
+#ifdef NRF24_LATENCY
+/* Add the time since start to a histogram, in the bucket of its bit length. */
+static void _latency(nrf24_t *radio, nrf24_latency_t which, uint32_t start){
+    nrf24_histogram_t *hist    = &radio->latency[which];
+    uint32_t           elapsed = machine->time.micros() - start;
+    uint32_t           rest    = elapsed;
+    uint8_t            bucket  = 0u;
+
+    while ((rest != 0u) && (bucket < (NRF24_HIST_BUCKETS - 1u))){
+        rest >>= 1u;
+        bucket++;
+    }
+
+    hist->buckets[bucket]++;
+    hist->count++;
+    if (elapsed > hist->max){
+        hist->max = elapsed;
+    }
+}
+#endif
+
+#ifdef NRF24_TRACE
+/* Register names by address, NULL for the reserved ones. */
+static const char *const trace_registers[NRF24_REG_COUNT] = {
+    [NRF_CONFIG] = "CONFIG",         [EN_AA] = "EN_AA",             [EN_RXADDR] = "EN_RXADDR", 
+    [SETUP_AW] = "SETUP_AW",         [SETUP_RETR] = "SETUP_RETR",   [RF_CH] = "RF_CH", 
+    [RF_SETUP] = "RF_SETUP",         [NRF_STATUS] = "STATUS",       [OBSERVE_TX] = "OBSERVE_TX", 
+    [RPD] = "RPD",                   [RX_ADDR_P0] = "RX_ADDR_P0",   [RX_ADDR_P1] = "RX_ADDR_P1", 
+    [RX_ADDR_P2] = "RX_ADDR_P2",     [RX_ADDR_P3] = "RX_ADDR_P3",   [RX_ADDR_P4] = "RX_ADDR_P4", 
+    [RX_ADDR_P5] = "RX_ADDR_P5",     [TX_ADDR] = "TX_ADDR",         [RX_PW_P0] = "RX_PW_P0", 
+    [RX_PW_P1] = "RX_PW_P1",         [RX_PW_P2] = "RX_PW_P2",       [RX_PW_P3] = "RX_PW_P3", 
+    [RX_PW_P4] = "RX_PW_P4",         [RX_PW_P5] = "RX_PW_P5",       [FIFO_STATUS] = "FIFO_STATUS", 
+    [DYNPD] = "DYNPD",               [FEATURE] = "FEATURE"
+};
+
+/* Name of the register or SPI command in nrf24_trace_entry_t.reg. */
+static const char *_traceName(uint8_t reg){
+    const char *name = NULL;
+
+    if (reg < NRF24_REG_COUNT){
+        name = trace_registers[reg];
+    } else if ((reg & 0xF8) == W_ACK_PAYLOAD){
+        name = "W_ACK_PAYLOAD";
+    } else {
+        switch (reg){
+            case ACTIVATE:            name = "ACTIVATE";            break;
+            case R_RX_PL_WID:         name = "R_RX_PL_WID";         break;
+            case R_RX_PAYLOAD:        name = "R_RX_PAYLOAD";        break;
+            case W_TX_PAYLOAD:        name = "W_TX_PAYLOAD";        break;
+            case W_TX_PAYLOAD_NO_ACK: name = "W_TX_PAYLOAD_NO_ACK"; break;
+            case FLUSH_TX:            name = "FLUSH_TX";            break;
+            case FLUSH_RX:            name = "FLUSH_RX";            break;
+            case REUSE_TX_PL:         name = "REUSE_TX_PL";         break;
+            case RF24_NOP:            name = "NOP";                 break;
+            default:                                                break;
+        }
+    }
+    return (name != NULL) ? name : "?";
+}
+
+/* Render everything of an entry except the timestamp and status, for nRF24_traceDump. */
+static void _traceDescribe(const nrf24_trace_entry_t *entry, char *out, size_t size){
+    static const char *const errors[] = { "OK", "ERROR", "NULL_POINTER", "ARG_INVALID", "TIMEOUT" };
+    char    bits[9u];
+    uint8_t bit = 0u;
+
+    for (bit = 0u; bit < 8u; ++bit){
+        bits[bit] = (entry->value & (0x80 >> bit)) ? '1' : '0';
+    }
+    bits[8u] = '\0';
+
+    switch (entry->op){
+        case NRF24_TRACE_READ:
+        case NRF24_TRACE_WRITE:
+            (void)snprintf(out, size, "%s %-11s %02X %s", (entry->op == NRF24_TRACE_READ) ? "R" : "W", 
+                _traceName(entry->reg), entry->value, bits);
+            break;
+        case NRF24_TRACE_READ_NB:
+        case NRF24_TRACE_WRITE_NB:
+            (void)snprintf(out, size, "%s %-11s %02X..", (entry->op == NRF24_TRACE_READ_NB) ? "R" : "W", 
+                _traceName(entry->reg), entry->value);
+            break;
+        case NRF24_TRACE_TX_PAYLOAD:
+        case NRF24_TRACE_RX_PAYLOAD:
+            (void)snprintf(out, size, "%-19s %u bytes", _traceName(entry->reg), entry->value);
+            break;
+        case NRF24_TRACE_CE:
+            (void)snprintf(out, size, "CE %s", entry->value ? "HIGH" : "LOW");
+            break;
+        case NRF24_TRACE_ERROR:
+            (void)snprintf(out, size, "ERROR %s", 
+                (entry->reg < (sizeof(errors) / sizeof(errors[0]))) ? errors[entry->reg] : "?");
+            break;
+        default:
+            (void)snprintf(out, size, "? %02X %02X", entry->reg, entry->value);
+            break;
+    }
+}
+
+/* Append an entry to the trace ring, an error entry freezes it. */
+static void _trace(nrf24_t *radio, nrf24_trace_op_t op, uint8_t reg, uint8_t value){
+    nrf24_trace_entry_t *entry = NULL;
+
+    if (radio->trace_frozen){
+        return;
+    }
+
+    entry = &radio->trace[radio->trace_count & (NRF24_TRACE_DEPTH - 1u)];
+    entry->timestamp = machine->time.micros();
+    entry->op        = (uint8_t)op;
+    entry->reg       = reg;
+    entry->value     = value;
+    entry->status    = radio->spi_status;
+    radio->trace_count++;
+
+    if (op == NRF24_TRACE_ERROR){
+        radio->trace_frozen = true;
     }
 }
+#endif
 
-static bool _isinTxMode(void){
-    return (config_reg & _BV(PRIM_RX));
+static bool _isinTxMode(nrf24_t *radio){
+    return (radio->regs[NRF_CONFIG] & _BV(PRIM_RX));
 }
\ No newline at end of file
@@ -0,0 +1,128 @@
+#include "stdint.h"
+#include "stdbool.h"
+#include "string.h"
+
+#include "inc/hal/config.h"
+#include "inc/nRF24L01.h"
+#include "inc/nRF24.h"
+#include "inc/nRF24_ring.h"
+
+/**
+ * @brief Initialize an empty ring on top of caller owned slots.
+ *
+ * @param slots: Storage for depth frames, must outlive the ring.
+ * @param depth: A power of 2, at least 2.
+ * @return nrf24_status_t
+ */
+nrf24_status_t nRF24_ringInit(nrf24_ring_t *ring, nrf24_rx_frame_t *slots, size_t depth){
+    if ((ring == NULL) || (slots == NULL)){
+        return NRF24_NULL_POINTER;
+    }
+
+    if ((depth < 2u) || ((depth & (depth - 1u)) != 0u)){
+        return NRF24_ARG_INVALID;
+    }
+
+    ring->slots      = slots;
+    ring->mask       = depth - 1u;
+    ring->tail_cache = 0u;
+    ring->head_cache = 0u;
+    atomic_init(&ring->head, 0u);
+    atomic_init(&ring->tail, 0u);
+    atomic_init(&ring->dropped, 0u);
+
+    return NRF24_OK;
+};
+
+/**
+ * @brief Drain the RX FIFO of the radio into the ring, producer side.
+ *
+ * Frames are read straight into the free slots, one nRF24_readBurst per contiguous run.
+ *  When the ring is full the remaining frames are read and dropped, so the RX FIFO
+ *  keeps accepting payloads.
+ *
+ * @return nrf24_status_t
+ */
+nrf24_status_t nRF24_ringFill(nrf24_t *radio, nrf24_ring_t *ring){
+    nrf24_status_t   status = NRF24_OK;
+    size_t           head   = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t           depth  = ring->mask + 1u;
+    size_t           space  = 0u;
+    size_t           run    = 0u;
+    size_t           count  = 0u;
+    nrf24_rx_frame_t scratch[3u];
+
+    /* One bus hold for the whole drain, see nRF24_acquireBus. */
+    (void)nRF24_acquireBus(radio);
+    do {
+        space = depth - (head - ring->tail_cache);
+        if (space == 0u){
+            ring->tail_cache = atomic_load_explicit(&ring->tail, memory_order_acquire);
+            space = depth - (head - ring->tail_cache);
+        }
+
+        if (space == 0u){
+            status = nRF24_readBurst(radio, scratch, sizeof(scratch) / sizeof(scratch[0]), &count);
+            (void)atomic_fetch_add_explicit(&ring->dropped, (uint_least32_t)count, memory_order_relaxed);
+        } else {
+            /* Up to the end of the slots, the next round wraps around. */
+            run    = rf24_min(space, depth - (head & ring->mask));
+            status = nRF24_readBurst(radio, &ring->slots[head & ring->mask], run, &count);
+
+            head += count;
+            atomic_store_explicit(&ring->head, head, memory_order_release);
+        }
+        /* Stop once RX_P_NO reports an empty RX FIFO. */
+    } while ((status == NRF24_OK) && (count > 0u) && (((nRF24_getLastStatus(radio) >> RX_P_NO) & 0x07) <= 5u));
+    (void)nRF24_releaseBus(radio);
+
+    return status;
+};
+
+/**
+ * @brief nrf24_event_cb_t that fills the ring passed as arg, register it for NRF24_RX_DR.
+ *
+ * @example nRF24_onEvent(radio, NRF24_RX_DR, nRF24_ringRxHandler, &ring);
+ */
+void nRF24_ringRxHandler(nrf24_t *radio, nrf24_irq_flags_t event, void *arg){
+    (void)event;
+    (void)nRF24_ringFill(radio, (nrf24_ring_t *)arg);
+};
+
+/**
+ * @brief The oldest frame, consumer side. It stays valid (and can be decoded in place)
+ *  until nRF24_ringRelease.
+ *
+ * @return nrf24_rx_frame_t*: NULL when the ring is empty.
+ */
+nrf24_rx_frame_t *nRF24_ringPeek(nrf24_ring_t *ring){
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+    if (tail == ring->head_cache){
+        ring->head_cache = atomic_load_explicit(&ring->head, memory_order_acquire);
+        if (tail == ring->head_cache){
+            return NULL;
+        }
+    }
+    return &ring->slots[tail & ring->mask];
+};
+
+/* Hand the frame of nRF24_ringPeek back to the producer. */
+void nRF24_ringRelease(nrf24_ring_t *ring){
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+    atomic_store_explicit(&ring->tail, tail + 1u, memory_order_release);
+};
+
+/* Frames waiting, a snapshot that is safe from either side. */
+size_t nRF24_ringCount(nrf24_ring_t *ring){
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+    return head - tail;
+};
+
+/* Frames dropped because the ring was full, since nRF24_ringInit. */
+uint32_t nRF24_ringDropped(nrf24_ring_t *ring){
+    return (uint32_t)atomic_load_explicit(&ring->dropped, memory_order_relaxed);
+};
@@ -0,0 +1,132 @@
+#include "stdint.h"
+#include "stdbool.h"
+#include "stdio.h"
+#include "string.h"
+
+#include "inc/nRF24.h"
+#include "sim.h"
+
+/**
+ * @brief Request/response turnaround, nRF24_start/stopListening against the fast variants. 
+ * 
+ * Two linked radios ping-pong ROUNDS times, every hop is stop -> (work) -> write -> start on one 
+ *  side and available -> read on the other. The HAL costs are roughly those of the Luckfox (spidev 
+ *  ioctl, 10 MHz SCLK, gpiochip line set), so the simulated time is what the turnarounds cost there. 
+ *  Every CE high must respect the ready_at of the preceding stop. 
+ * 
+ * The txDelay after a stop is a floor for both variants. Replying right away, the transactions the 
+ *  fast stop saves are spent waiting for it. With work before the reply (building the response) 
+ *  the window is already hidden, and the saved transactions are saved time. 
+ */
+#define ROUNDS (1000u)
+
+typedef nrf24_status_t (*mode_fn_t)(nrf24_t *radio);
+
+typedef struct {
+    const char *name;
+    mode_fn_t   start;
+    mode_fn_t   stop;
+    uint32_t    work_us;
+    uint32_t    transactions;
+    uint64_t    ns;
+} variant_t;
+
+static const uint8_t ping_address[5u] = { '1', 'N', 'o', 'd', 'e' };
+static const uint8_t pong_address[5u] = { '2', 'N', 'o', 'd', 'e' };
+
+static nrf24_t *open_radio(uint8_t pins, const uint8_t *tx, const uint8_t *rx, sim_chip_t **chip){
+    nrf24_cfg_t   cfg   = NRF24_DEFAULT_CFG(pins, (uint8_t)(pins + 1u));
+    spi_handle_t *spi   = machine->spi.open(0u, 10000000u, 0u);
+    nrf24_t      *radio = NULL;
+
+    CHECK(spi != NULL);
+    *chip = sim_chip(spi);
+    sim_wire(*chip, (uint8_t)(pins + 1u), (uint8_t)(pins + 2u));
+
+    CHECK(nRF24_init(&radio, spi, &cfg) == NRF24_OK);
+    CHECK(nRF24_openWritingPipe(radio, tx) == NRF24_OK);
+    CHECK(nRF24_openReadingPipe(radio, 1u, rx) == NRF24_OK);
+    return radio;
+}
+
+/* One hop, from is listening and answers to, which is listening too. */
+static void hop(variant_t *v, nrf24_t *from, sim_chip_t *chip, nrf24_t *to, uint32_t seq){
+    uint8_t  buffer[32u];
+    uint32_t ready_at = 0u;
+
+    (void)memset(buffer, 0, sizeof(buffer));
+    (void)memcpy(buffer, &seq, sizeof(seq));
+
+    CHECK(v->stop(from) == NRF24_OK);
+    CHECK(nRF24_getState(from, &(nrf24_state_t){ 0 }, &ready_at) == NRF24_OK);
+    sim_advance_us(v->work_us);
+    CHECK(nRF24_write(from, buffer, sizeof(buffer), false) == NRF24_OK);
+    CHECK((int32_t)(machine->time.micros() - ready_at) >= 0);
+    CHECK(chip->ce_early == 0u);
+    CHECK(v->start(from) == NRF24_OK);
+
+    (void)memset(buffer, 0, sizeof(buffer));
+    CHECK(nRF24_available(to));
+    CHECK(nRF24_read(to, buffer, sizeof(buffer)) == NRF24_OK);
+    CHECK(memcmp(buffer, &seq, sizeof(seq)) == 0);
+}
+
+static void run(variant_t *v, uint8_t pins){
+    sim_chip_t *ping_chip = NULL;
+    sim_chip_t *pong_chip = NULL;
+    nrf24_t    *ping      = open_radio(pins, ping_address, pong_address, &ping_chip);
+    nrf24_t    *pong      = open_radio((uint8_t)(pins + 3u), pong_address, ping_address, &pong_chip);
+    uint64_t    start     = 0u;
+
+    sim_link(ping_chip, pong_chip);
+    CHECK(v->start(ping) == NRF24_OK);
+    CHECK(v->start(pong) == NRF24_OK);
+    sim_advance_us(NRF24_TPD2STBY_US);
+
+    ping_chip->transactions = 0u;
+    pong_chip->transactions = 0u;
+    start = sim_now_ns();
+
+    for (uint32_t seq = 0u; seq < ROUNDS; ++seq){
+        hop(v, ping, ping_chip, pong, seq);
+        hop(v, pong, pong_chip, ping, ~seq);
+    }
+
+    v->ns           = sim_now_ns() - start;
+    v->transactions = ping_chip->transactions + pong_chip->transactions;
+
+    CHECK(nRF24_deinit(&ping) == NRF24_OK);
+    CHECK(nRF24_deinit(&pong) == NRF24_OK);
+}
+
+static void report(const variant_t *v){
+    printf("  %-28s work %3u us: %6.2f transactions %8.1f us per round trip\r\n", v->name, (unsigned)v->work_us,
+           (double)v->transactions / ROUNDS, (double)v->ns / 1000.0 / ROUNDS);
+}
+
+int main(void){
+    static const uint32_t work_us[] = { 0u, 200u };
+
+    nRF24_halInit(&machine);
+    sim_cost.spi_call_ns = 20000u;
+    sim_cost.spi_byte_ns = 800u;
+    sim_cost.gpio_ns     = 5000u;
+
+    printf("%u round trips, 1 Mbps\r\n", (unsigned)ROUNDS);
+    for (size_t i = 0u; i < (sizeof(work_us) / sizeof(work_us[0u])); ++i){
+        variant_t standard = { "start/stopListening",         nRF24_startListening,     nRF24_stopListening,     work_us[i], 0u, 0u };
+        variant_t fast     = { "fastStart/fastStopListening", nRF24_fastStartListening, nRF24_fastStopListening, work_us[i], 0u, 0u };
+
+        run(&standard, (uint8_t)(i * 20u));
+        run(&fast, (uint8_t)(i * 20u + 10u));
+        report(&standard);
+        report(&fast);
+        printf("  speed-up %.2fx\r\n", (double)standard.ns / (double)fast.ns);
+
+        CHECK(fast.transactions < standard.transactions);
+        if (work_us[i] > 0u){
+            CHECK(fast.ns < standard.ns);
+        }
+    }
+    return 0;
+}
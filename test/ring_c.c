@@ -0,0 +1,32 @@
+#include "stddef.h"
+#include "stdalign.h"
+
+#include "inc/nRF24.h"
+#include "inc/nRF24_ring.h"
+#include "sim.h"
+
+/* The C side of test_ring.cpp. */
+
+/* nrf24_ring_t as the C driver sees it, test_ring.cpp compares its own view against this. */
+const size_t ring_layout_c[] = {
+    sizeof(nrf24_ring_t),
+    alignof(nrf24_ring_t),
+    offsetof(nrf24_ring_t, head),
+    offsetof(nrf24_ring_t, tail_cache),
+    offsetof(nrf24_ring_t, dropped),
+    offsetof(nrf24_ring_t, tail),
+    offsetof(nrf24_ring_t, head_cache)
+};
+
+/* NRF24_DEFAULT_CFG uses C designated initializers, out of order for C++. */
+nrf24_t *ring_open_radio(uint8_t pins, sim_chip_t **chip){
+    nrf24_cfg_t   cfg   = NRF24_DEFAULT_CFG(pins, (uint8_t)(pins + 1u));
+    spi_handle_t *spi   = machine->spi.open(0u, 10000000u, 0u);
+    nrf24_t      *radio = NULL;
+
+    CHECK(spi != NULL);
+    *chip = sim_chip(spi);
+    sim_wire(*chip, (uint8_t)(pins + 1u), (uint8_t)(pins + 2u));
+    CHECK(nRF24_init(&radio, spi, &cfg) == NRF24_OK);
+    return radio;
+}
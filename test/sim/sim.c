@@ -0,0 +1,493 @@
+#include "stdint.h"
+#include "stdbool.h"
+#include "stdlib.h"
+#include "string.h"
+#include "stdatomic.h"
+#include "pthread.h"
+#include "sched.h"
+
+#include "inc/hal/config.h"
+#include "inc/hal/machine.h"
+#include "inc/nRF24.h"
+
+#include "sim.h"
+
+#define IRQ_MASK (_BV(RX_DR) | _BV(TX_DS) | _BV(MAX_RT))
+
+struct spi_handle {
+    sim_chip_t chip;
+};
+
+sim_cost_t sim_cost = { 0u, 0u, 0u };
+
+/* All chips share one lock, a transmission touches two of them. */
+static pthread_mutex_t sim_lock = PTHREAD_MUTEX_INITIALIZER;
+static _Atomic uint64_t sim_clock_ns;
+static sim_chip_t *sim_pins[256u];
+static uint32_t sim_gpio_count;
+
+static void sim_reset(sim_chip_t *c);
+static uint8_t sim_status(sim_chip_t *c);
+static uint8_t sim_fifo_status(sim_chip_t *c);
+static int sim_match(sim_chip_t *rx, const uint8_t *address);
+static void sim_ack_payload(sim_chip_t *c, sim_chip_t *rx, int pipe);
+static void sim_air(sim_chip_t *c);
+static void sim_irq(sim_chip_t *c);
+static void sim_command(sim_chip_t *c, const uint8_t *tx, uint8_t *rx, size_t len);
+
+uint64_t sim_now_ns(void){
+    return atomic_load(&sim_clock_ns);
+}
+
+void sim_advance_us(uint32_t us){
+    (void)atomic_fetch_add(&sim_clock_ns, (uint64_t)us * 1000u);
+}
+
+uint32_t sim_gpio_writes(void){
+    uint32_t count = 0u;
+
+    (void)pthread_mutex_lock(&sim_lock);
+    count = sim_gpio_count;
+    (void)pthread_mutex_unlock(&sim_lock);
+    return count;
+}
+
+sim_chip_t *sim_chip(spi_handle_t *spi){
+    return &spi->chip;
+}
+
+void sim_wire(sim_chip_t *chip, uint8_t ce, uint8_t irq){
+    (void)pthread_mutex_lock(&sim_lock);
+    chip->ce_pin   = ce;
+    chip->irq_pin  = irq;
+    sim_pins[ce]   = chip;
+    sim_pins[irq]  = chip;
+    (void)pthread_mutex_unlock(&sim_lock);
+}
+
+void sim_link(sim_chip_t *a, sim_chip_t *b){
+    (void)pthread_mutex_lock(&sim_lock);
+    a->peer = b;
+    b->peer = a;
+    (void)pthread_mutex_unlock(&sim_lock);
+}
+
+/* Power on reset values, see the register map of the datasheet. */
+static void sim_reset(sim_chip_t *c){
+    (void)memset(c, 0, sizeof(*c));
+    c->regs[NRF_CONFIG]  = 0x08;
+    c->regs[EN_AA]       = 0x3F;
+    c->regs[EN_RXADDR]   = 0x03;
+    c->regs[SETUP_AW]    = 0x03;
+    c->regs[SETUP_RETR]  = 0x03;
+    c->regs[RF_CH]       = 0x02;
+    c->regs[RF_SETUP]    = 0x0F;
+    c->regs[NRF_STATUS]  = 0x0E;
+    (void)memset(c->rx_addr[0u], 0xE7, 5u);
+    (void)memset(c->rx_addr[1u], 0xC2, 5u);
+    for (uint8_t pipe = 2u; pipe < 6u; ++pipe){
+        c->rx_addr[pipe][0u] = (uint8_t)(0xC1 + pipe);
+    }
+    (void)memset(c->tx_addr, 0xE7, 5u);
+}
+
+static uint8_t sim_status(sim_chip_t *c){
+    uint8_t status = (uint8_t)(c->regs[NRF_STATUS] & IRQ_MASK);
+
+    status |= (uint8_t)(((c->rx_count > 0u) ? c->rx[0u].pipe : 7u) << RX_P_NO);
+    if (c->tx_count == 3u){
+        status |= _BV(TX_FULL);
+    }
+    return status;
+}
+
+static uint8_t sim_fifo_status(sim_chip_t *c){
+    return (uint8_t)(((c->rx_count == 0u) ? 0x01 : 0u) | ((c->rx_count == 3u) ? 0x02 : 0u) |
+                     ((c->tx_count == 0u) ? 0x10 : 0u) | ((c->tx_count == 3u) ? 0x20 : 0u));
+}
+
+/* The pipe of rx that listens to address, -1 if none. Pipes 2-5 share the upper bytes of pipe 1. */
+static int sim_match(sim_chip_t *rx, const uint8_t *address){
+    size_t width = (size_t)rx->regs[SETUP_AW] + 2u;
+
+    for (int pipe = 0; pipe < 6; ++pipe){
+        if (!(rx->regs[EN_RXADDR] & (1u << pipe))){
+            continue;
+        }
+        if ((pipe < 2) && (memcmp(rx->rx_addr[pipe], address, width) == 0)){
+            return pipe;
+        }
+        if ((pipe >= 2) && (rx->rx_addr[pipe][0u] == address[0u]) &&
+            (memcmp(&rx->rx_addr[1u][1u], &address[1u], width - 1u) == 0)){
+            return pipe;
+        }
+    }
+    return -1;
+}
+
+/* The ACK of rx on pipe carries the first ack payload loaded for that pipe, c gets it on pipe 0. */
+static void sim_ack_payload(sim_chip_t *c, sim_chip_t *rx, int pipe){
+    for (uint8_t i = 0u; (i < rx->tx_count) && (c->rx_count < 3u); ++i){
+        if (rx->tx[i].pipe != (uint8_t)pipe){
+            continue;
+        }
+        c->rx[c->rx_count]      = rx->tx[i];
+        c->rx[c->rx_count].pipe = 0u;
+        c->rx_count++;
+        c->regs[NRF_STATUS] |= _BV(RX_DR);
+
+        (void)memmove(&rx->tx[i], &rx->tx[i + 1u], sizeof(rx->tx[0u]) * (size_t)(rx->tx_count - i - 1u));
+        rx->tx_count--;
+        break;
+    }
+}
+
+/* A PTX with CE high sends its TX FIFO, instantly. Acked when the peer is listening and not 
+    every try is dropped (sim_chip_t.drop). The ACK carries an ack payload when the peer has 
+    one loaded for the pipe (EN_ACK_PAY on both). */
+static void sim_air(sim_chip_t *c){
+    sim_chip_t *rx    = c->peer;
+    int         pipe  = -1;
+    uint8_t     retr  = 0u;
+    uint8_t     tries = 0u;
+
+    while (c->ce && (c->regs[NRF_CONFIG] & _BV(PWR_UP)) && !(c->regs[NRF_CONFIG] & _BV(PRIM_RX)) &&
+           (c->tx_count > 0u) && !(c->regs[NRF_STATUS] & _BV(MAX_RT))){
+        pipe = -1;
+        if ((rx != NULL) && rx->ce && ((rx->regs[NRF_CONFIG] & (_BV(PWR_UP) | _BV(PRIM_RX))) == (_BV(PWR_UP) | _BV(PRIM_RX)))){
+            pipe = sim_match(rx, c->tx_addr);
+        }
+
+        /* Lost transmissions, the first and up to SETUP_RETR retransmits. */
+        retr  = (uint8_t)(c->regs[SETUP_RETR] & 0x0F);
+        tries = 0u;
+        if (c->regs[EN_AA] & 0x01){
+            tries    = (uint8_t)rf24_min(c->drop, (uint32_t)retr + 1u);
+            c->drop -= tries;
+        }
+
+        if ((tries <= retr) && (pipe >= 0) && (rx->rx_count < 3u)){
+            c->regs[OBSERVE_TX] = (uint8_t)((c->regs[OBSERVE_TX] & 0xF0) | tries);
+            rx->rx[rx->rx_count]      = c->tx[0u];
+            rx->rx[rx->rx_count].pipe = (uint8_t)pipe;
+            rx->rx_count++;
+            rx->regs[NRF_STATUS] |= _BV(RX_DR);
+            if ((c->regs[EN_AA] & 0x01) && (c->regs[FEATURE] & rx->regs[FEATURE] & _BV(EN_ACK_PAY))){
+                sim_ack_payload(c, rx, pipe);
+            }
+            sim_irq(rx);
+        } else if (c->regs[EN_AA] & 0x01){
+            /* Not acked, retransmitted SETUP_RETR times in vain. */
+            c->regs[OBSERVE_TX]  = (uint8_t)((rf24_min((c->regs[OBSERVE_TX] >> PLOS_CNT) + 1u, 15u) << PLOS_CNT) | retr);
+            c->regs[NRF_STATUS] |= _BV(MAX_RT);
+            break;
+        }
+
+        c->regs[NRF_STATUS] |= _BV(TX_DS);
+        (void)memmove(&c->tx[0u], &c->tx[1u], sizeof(c->tx[0u]) * 2u);
+        c->tx_count--;
+    }
+    sim_irq(c);
+}
+
+/* IRQ is active low while an unmasked flag is set, the callback runs on the falling edge. */
+static void sim_irq(sim_chip_t *c){
+    bool low = (c->regs[NRF_STATUS] & IRQ_MASK & ~c->regs[NRF_CONFIG]) != 0u;
+
+    if (low && !c->irq_low && (c->irq_callback != NULL)){
+        c->irq_callback(c->irq_arg);
+    }
+    c->irq_low = low;
+}
+
+static void sim_command(sim_chip_t *c, const uint8_t *tx, uint8_t *rx, size_t len){
+    uint8_t  cmd   = tx[0u];
+    uint8_t  reg   = (uint8_t)(cmd & REGISTER_MASK);
+    uint8_t *bytes = NULL;
+    uint8_t  out[33u];
+
+    (void)memset(out, 0, sizeof(out));
+    out[0u] = sim_status(c);
+    len     = rf24_min(len, sizeof(out));
+
+    if (cmd < W_REGISTER){
+        bytes = (reg <= RX_ADDR_P5 && reg >= RX_ADDR_P0) ? c->rx_addr[reg - RX_ADDR_P0] :
+                (reg == TX_ADDR) ? c->tx_addr : NULL;
+        c->regs[FIFO_STATUS] = sim_fifo_status(c);
+        for (size_t i = 1u; i < len; ++i){
+            out[i] = (bytes != NULL) ? bytes[rf24_min(i - 1u, 4u)] : ((reg == NRF_STATUS) ? out[0u] : c->regs[reg]);
+        }
+    } else if (cmd < ACTIVATE){
+        bytes = (reg <= RX_ADDR_P5 && reg >= RX_ADDR_P0) ? c->rx_addr[reg - RX_ADDR_P0] :
+                (reg == TX_ADDR) ? c->tx_addr : NULL;
+        if (len < 2u){
+            /* No data byte. */
+        } else if (bytes != NULL){
+            (void)memcpy(bytes, &tx[1u], rf24_min(len - 1u, 5u));
+        } else if (reg == NRF_STATUS){
+            c->regs[NRF_STATUS] &= (uint8_t)~(tx[1u] & IRQ_MASK);
+        } else if ((reg != FIFO_STATUS) && (reg != OBSERVE_TX)){
+            if ((reg == NRF_CONFIG) && (tx[1u] & _BV(PWR_UP)) && !(c->regs[NRF_CONFIG] & _BV(PWR_UP))){
+                c->powered_at = sim_now_ns();
+            }
+            if (reg == RF_CH){
+                c->regs[OBSERVE_TX] &= 0x0F;
+            }
+            c->regs[reg] = tx[1u];
+        }
+    } else if ((cmd == R_RX_PL_WID) && (len > 1u)){
+        out[1u] = (c->rx_count > 0u) ? c->rx[0u].length : 0u;
+    } else if (cmd == R_RX_PAYLOAD){
+        for (size_t i = 1u; (i < len) && (c->rx_count > 0u); ++i){
+            out[i] = c->rx[0u].data[i - 1u];
+        }
+        if (c->rx_count > 0u){
+            (void)memmove(&c->rx[0u], &c->rx[1u], sizeof(c->rx[0u]) * 2u);
+            c->rx_count--;
+        }
+    } else if (((cmd == W_TX_PAYLOAD) || (cmd == W_TX_PAYLOAD_NO_ACK) || ((cmd & ~0x07) == W_ACK_PAYLOAD)) &&
+               (c->tx_count < 3u)){
+        /* An ack payload keeps its pipe in the TX FIFO, the ACK on that pipe takes it. */
+        c->tx[c->tx_count].pipe   = ((cmd & ~0x07) == W_ACK_PAYLOAD) ? (uint8_t)(cmd & 0x07) : 0u;
+        c->tx[c->tx_count].length = (uint8_t)(len - 1u);
+        (void)memcpy(c->tx[c->tx_count].data, &tx[1u], len - 1u);
+        c->tx_count++;
+    } else if (cmd == FLUSH_TX){
+        c->tx_count = 0u;
+    } else if (cmd == FLUSH_RX){
+        c->rx_count = 0u;
+    }
+    /* ACTIVATE and REUSE_TX_PL are not simulated, this is a plus variant. */
+
+    if (rx != NULL){
+        (void)memcpy(rx, out, len);
+    }
+    sim_air(c);
+}
+
+/* Begin: machine->spi */
+static spi_handle_t *spi_open(uint8_t bus, uint32_t freq_hz, uint8_t mode){
+    spi_handle_t *h = (spi_handle_t *)calloc(1u, sizeof(spi_handle_t));
+
+    (void)bus;
+    (void)freq_hz;
+    (void)mode;
+    if (h != NULL){
+        sim_reset(&h->chip);
+    }
+    return h;
+}
+
+static int spi_begin_transaction(spi_handle_t *h){
+    (void)h;
+    return 0;
+}
+
+static void spi_end_transaction(spi_handle_t *h){
+    (void)h;
+}
+
+static int spi_transfer(spi_handle_t *h, const uint8_t *tx, uint8_t *rx, size_t len){
+    (void)atomic_fetch_add(&sim_clock_ns, (uint64_t)sim_cost.spi_call_ns + ((uint64_t)sim_cost.spi_byte_ns * len));
+
+    (void)pthread_mutex_lock(&sim_lock);
+    h->chip.spi_calls++;
+    h->chip.transactions++;
+    h->chip.bytes += (uint32_t)len;
+    sim_command(&h->chip, tx, rx, len);
+    (void)pthread_mutex_unlock(&sim_lock);
+    return 1;
+}
+
+static int spi_write(spi_handle_t *h, const uint8_t *data, size_t len){
+    return spi_transfer(h, data, NULL, len);
+}
+
+static int spi_read(spi_handle_t *h, uint8_t *data, size_t len){
+    uint8_t tx[33u];
+
+    (void)memset(tx, RF24_NOP, sizeof(tx));
+    return spi_transfer(h, tx, data, rf24_min(len, sizeof(tx)));
+}
+
+/* Gathered into one transfer, a transaction is one command for the chip. */
+static int spi_transferv(spi_handle_t *h, const spi_segment_t *segments, size_t count){
+    uint8_t tx[33u];
+    uint8_t rx[33u];
+    size_t  len = 0u;
+    int     status = 0;
+
+    for (size_t i = 0u; i < count; ++i){
+        if (segments[i].tx != NULL){
+            (void)memcpy(&tx[len], segments[i].tx, segments[i].len);
+        } else {
+            (void)memset(&tx[len], RF24_NOP, segments[i].len);
+        }
+        len += segments[i].len;
+    }
+
+    status = spi_transfer(h, tx, rx, len);
+
+    len = 0u;
+    for (size_t i = 0u; i < count; ++i){
+        if (segments[i].rx != NULL){
+            (void)memcpy(segments[i].rx, &rx[len], segments[i].len);
+        }
+        len += segments[i].len;
+    }
+    return status;
+}
+
+/* Like spidev, the backend drives only the chip select of the device itself. */
+static int spi_chip_select(spi_handle_t *h, uint8_t pin){
+    (void)h;
+    return (pin == SPI_HW_CS) ? 0 : -1;
+}
+
+/* One call, CSN released between the segments, so each one is a command for the chip. */
+static int spi_batch(spi_handle_t *h, const spi_segment_t *transactions, size_t count){
+    uint8_t tx[33u];
+    size_t  bytes = 0u;
+
+    (void)memset(tx, RF24_NOP, sizeof(tx));
+    for (size_t i = 0u; i < count; ++i){
+        bytes += transactions[i].len;
+    }
+    (void)atomic_fetch_add(&sim_clock_ns, (uint64_t)sim_cost.spi_call_ns + ((uint64_t)sim_cost.spi_byte_ns * bytes));
+
+    (void)pthread_mutex_lock(&sim_lock);
+    h->chip.spi_calls++;
+    for (size_t i = 0u; i < count; ++i){
+        h->chip.transactions++;
+        h->chip.bytes += (uint32_t)transactions[i].len;
+        sim_command(&h->chip, (transactions[i].tx != NULL) ? transactions[i].tx : tx, transactions[i].rx,
+                    rf24_min(transactions[i].len, sizeof(tx)));
+    }
+    (void)pthread_mutex_unlock(&sim_lock);
+    return 1;
+}
+
+static void spi_close(spi_handle_t *h){
+    free(h);
+}
+
+/* Begin: machine->gpio */
+static int gpio_config(uint8_t pin, bool output){
+    (void)pin;
+    (void)output;
+    return 0;
+}
+
+static int gpio_write(uint8_t pin, bool level){
+    sim_chip_t *c = NULL;
+
+    (void)atomic_fetch_add(&sim_clock_ns, (uint64_t)sim_cost.gpio_ns);
+
+    (void)pthread_mutex_lock(&sim_lock);
+    sim_gpio_count++;
+    if (((c = sim_pins[pin]) != NULL) && (c->ce_pin == pin)){
+        c->gpio_writes++;
+        if (level && !c->ce && (c->regs[NRF_CONFIG] & _BV(PWR_UP)) &&
+            ((sim_now_ns() - c->powered_at) < ((uint64_t)NRF24_TPD2STBY_US * 1000u))){
+            c->ce_early++;
+        }
+        c->ce = level;
+        sim_air(c);
+    }
+    (void)pthread_mutex_unlock(&sim_lock);
+    return 0;
+}
+
+static bool gpio_read(uint8_t pin){
+    sim_chip_t *c     = NULL;
+    bool        level = false;
+
+    (void)pthread_mutex_lock(&sim_lock);
+    if (((c = sim_pins[pin]) != NULL) && (c->irq_pin == pin)){
+        level = !c->irq_low;
+    }
+    (void)pthread_mutex_unlock(&sim_lock);
+    return level;
+}
+
+static int gpio_attach_interrupt(uint8_t pin, void (*callback)(void *arg), void *arg){
+    sim_chip_t *c      = NULL;
+    int         status = -1;
+
+    (void)pthread_mutex_lock(&sim_lock);
+    if (((c = sim_pins[pin]) != NULL) && (c->irq_pin == pin)){
+        c->irq_callback = callback;
+        c->irq_arg      = arg;
+        status          = 0;
+    }
+    (void)pthread_mutex_unlock(&sim_lock);
+    return status;
+}
+
+static int gpio_detach_interrupt(uint8_t pin){
+    sim_chip_t *c = NULL;
+
+    (void)pthread_mutex_lock(&sim_lock);
+    if (((c = sim_pins[pin]) != NULL) && (c->irq_pin == pin)){
+        c->irq_callback = NULL;
+    }
+    (void)pthread_mutex_unlock(&sim_lock);
+    return 0;
+}
+
+/* Begin: machine->sleep, yield so the threads of a test interleave. */
+static void sleep_us(uint32_t us){
+    sim_advance_us(us);
+    (void)sched_yield();
+}
+
+static void sleep_ms(uint32_t ms){
+    sleep_us(ms * 1000u);
+}
+
+/* Begin: machine->time */
+static uint32_t millis(void){
+    return (uint32_t)(sim_now_ns() / 1000000u);
+}
+
+static uint32_t micros(void){
+    return (uint32_t)(sim_now_ns() / 1000u);
+}
+
+static const machine_t sim_machine = {
+    .spi   = {
+        .open             = spi_open,
+        .beginTransaction = spi_begin_transaction,
+        .endTransaction   = spi_end_transaction,
+        .write            = spi_write,
+        .read             = spi_read,
+        .transfer         = spi_transfer,
+        .transferv        = spi_transferv,
+        .close            = spi_close,
+        .chipSelect       = spi_chip_select,
+        .batch            = spi_batch
+    },
+    .gpio  = {
+        .config          = gpio_config,
+        .write           = gpio_write,
+        .read            = gpio_read,
+        .attachInterrupt = gpio_attach_interrupt,
+        .detachInterrupt = gpio_detach_interrupt
+    },
+    .sleep = {
+        .ms = sleep_ms,
+        .us = sleep_us
+    },
+    .time  = {
+        .millis = millis,
+        .micros = micros
+    }
+};
+
+const machine_t *machine = NULL;
+
+void nRF24_halInit(const machine_t **hal){
+    if (hal != NULL){
+        *hal = &sim_machine;
+    }
+}
@@ -0,0 +1,102 @@
+#ifndef NRF24_SIM_H
+#define NRF24_SIM_H
+
+#include "stdint.h"
+#include "stdbool.h"
+#include "stdio.h"
+#include "stdlib.h"
+
+#include "inc/hal/machine.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Host test HAL: simulated nRF24L01+ chips behind machine->spi, and a simulated clock.
+ *
+ * Time only moves through machine->sleep and the cost of the HAL calls (sim_cost), so the
+ *  timing checks are exact and repeatable, and a benchmark measures the driver instead of
+ *  the host. Every machine->spi.open returns a new chip, two linked chips (sim_link) hear
+ *  each other on air. Like spidev, machine->spi.chipSelect takes over only SPI_HW_CS, a chip
+ *  with any other CSN pin is selected through machine->gpio. Thread safe, the chips share one lock.
+ */
+typedef struct {
+    uint32_t spi_call_ns;   // Per machine->spi.transfer(v) or batch, e.g. the ioctl of spidev.
+    uint32_t spi_byte_ns;   // Per byte clocked, 800 ns at 10 MHz.
+    uint32_t gpio_ns;       // Per machine->gpio.write, CE and CSN.
+} sim_cost_t;
+
+typedef struct {
+    uint8_t pipe;
+    uint8_t length;
+    uint8_t data[32u];
+} sim_payload_t;
+
+typedef struct sim_chip sim_chip_t;
+struct sim_chip {
+    uint8_t regs[0x20u];
+    uint8_t rx_addr[6u][5u];
+    uint8_t tx_addr[5u];
+
+    sim_payload_t rx[3u];
+    sim_payload_t tx[3u];
+    uint8_t       rx_count;
+    uint8_t       tx_count;
+
+    uint8_t     ce_pin;
+    uint8_t     irq_pin;
+    bool        ce;
+    bool        irq_low;
+    void      (*irq_callback)(void *arg);
+    void       *irq_arg;
+    sim_chip_t *peer;
+
+    /* sim_now_ns when PWR_UP went 0 -> 1. */
+    uint64_t powered_at;
+
+    /* Transmissions of this PTX to lose before the next one is acked, set by the tests. Each 
+        retransmit takes one, ARC_CNT tells how many a payload used. */
+    uint32_t drop;
+
+    /* Counters, for the tests to check. A machine->spi.batch is one of spi_calls and a transaction 
+        per segment. ce_early counts CE highs within Tpd2stby of PWR_UP. */
+    uint32_t spi_calls;
+    uint32_t transactions;
+    uint32_t bytes;
+    uint32_t gpio_writes;
+    uint32_t ce_early;
+};
+
+extern sim_cost_t sim_cost;
+
+/* The chip behind a handle of machine->spi.open. */
+extern sim_chip_t *sim_chip(spi_handle_t *spi);
+
+/* Connect the CE and IRQ pins of a chip, pins are global like on a board. */
+extern void sim_wire(sim_chip_t *chip, uint8_t ce, uint8_t irq);
+
+/* Put two chips on air together, a PTX delivers to (and is acked by) its peer. */
+extern void sim_link(sim_chip_t *a, sim_chip_t *b);
+
+/* machine->gpio.write calls on any pin, CSN included. */
+extern uint32_t sim_gpio_writes(void);
+
+extern uint64_t sim_now_ns(void);
+extern void     sim_advance_us(uint32_t us);
+
+/* Test helpers, a failed CHECK ends the test with exit code 1. */
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            printf("%s:%d: CHECK(%s) failed\r\n", __FILE__, __LINE__, #cond); \
+            exit(1); \
+        } \
+    } while (0)
+
+/* ctest SKIP_RETURN_CODE, for tests that need something the host does not have. */
+#define SIM_SKIP (77)
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,89 @@
+#include "stdint.h"
+#include "stdbool.h"
+#include "stdio.h"
+#include "string.h"
+
+#include "inc/nRF24.h"
+#include "sim.h"
+
+/**
+ * @brief Ack payloads end to end: the PRX loads them with nRF24_writeAckPayload (one transaction
+ *  each), the PTX gets them back from nRF24_writeWithAck, per pipe and in order. A full TX FIFO
+ *  refuses the fourth.
+ */
+static const uint8_t address[5u] = { '1', 'N', 'o', 'd', 'e' };
+
+static nrf24_t *open_radio(uint8_t pins, sim_chip_t **chip){
+    nrf24_cfg_t   cfg   = NRF24_DEFAULT_CFG(pins, (uint8_t)(pins + 1u));
+    spi_handle_t *spi   = machine->spi.open(0u, 10000000u, 0u);
+    nrf24_t      *radio = NULL;
+
+    cfg.ack.ackPayload = true;
+
+    CHECK(spi != NULL);
+    *chip = sim_chip(spi);
+    sim_wire(*chip, (uint8_t)(pins + 1u), (uint8_t)(pins + 2u));
+
+    CHECK(nRF24_init(&radio, spi, &cfg) == NRF24_OK);
+    return radio;
+}
+
+int main(void){
+    static const char *const replies[3u] = { "pong", "second reply", "3" };
+
+    sim_chip_t      *ptx_chip = NULL;
+    sim_chip_t      *prx_chip = NULL;
+    nrf24_t         *ptx      = NULL;
+    nrf24_t         *prx      = NULL;
+    nrf24_rx_frame_t ack;
+    uint8_t          buffer[32u];
+    uint8_t          received = 0u;
+    uint32_t         before   = 0u;
+
+    nRF24_halInit(&machine);
+    ptx = open_radio(0u, &ptx_chip);
+    prx = open_radio(3u, &prx_chip);
+    sim_link(ptx_chip, prx_chip);
+
+    CHECK(nRF24_openWritingPipe(ptx, address) == NRF24_OK);
+    CHECK(nRF24_openReadingPipe(prx, 1u, address) == NRF24_OK);
+    CHECK(nRF24_startListening(prx) == NRF24_OK);
+    CHECK(nRF24_stopListening(ptx) == NRF24_OK);
+
+    /* Loaded before the request comes in, straight from the caller's buffer. */
+    for (size_t i = 0u; i < 3u; ++i){
+        before = prx_chip->transactions;
+        CHECK(nRF24_writeAckPayload(prx, 1u, replies[i], (uint8_t)strlen(replies[i])) == NRF24_OK);
+        CHECK(prx_chip->transactions == before + 1u);
+    }
+    CHECK(nRF24_writeAckPayload(prx, 1u, "full", 4u) == NRF24_ERROR);
+    CHECK(prx_chip->tx_count == 3u);
+
+    for (size_t i = 0u; i < 3u; ++i){
+        (void)memset(&ack, 0, sizeof(ack));
+        CHECK(nRF24_writeWithAck(ptx, "ping", 4u, &ack) == NRF24_OK);
+        CHECK(ack.pipe == 0u);
+        CHECK(ack.length == strlen(replies[i]));
+        CHECK(memcmp(ack.data, replies[i], ack.length) == 0);
+
+        CHECK(nRF24_available(prx));
+        CHECK(nRF24_readPayload(prx, buffer, sizeof(buffer), &received) == NRF24_OK);
+        CHECK((received == 4u) && (memcmp(buffer, "ping", 4u) == 0));
+    }
+    CHECK(prx_chip->tx_count == 0u);
+
+    /* Nothing loaded, an empty ACK. */
+    CHECK(nRF24_writeWithAck(ptx, "ping", 4u, &ack) == NRF24_OK);
+    CHECK(ack.length == 0u);
+
+    /* A payload for another pipe does not ride on the ACKs of pipe 1. */
+    CHECK(nRF24_writeAckPayload(prx, 2u, "other", 5u) == NRF24_OK);
+    CHECK(nRF24_writeWithAck(ptx, "ping", 4u, &ack) == NRF24_OK);
+    CHECK(ack.length == 0u);
+    CHECK(prx_chip->tx_count == 1u);
+
+    CHECK(nRF24_deinit(&ptx) == NRF24_OK);
+    CHECK(nRF24_deinit(&prx) == NRF24_OK);
+    printf("ack payload ok\r\n");
+    return 0;
+}
@@ -0,0 +1,152 @@
+#include "stdint.h"
+#include "stdbool.h"
+#include "stdio.h"
+#include "string.h"
+
+#include "inc/nRF24.h"
+#include "sim.h"
+
+/**
+ * @brief machine->spi.chipSelect and machine->spi.batch: the same exchange with CSN on the SPI
+ *  device (SPI_HW_CS) and on a GPIO. The backend drives CSN without a single machine->gpio.write
+ *  for it, the batched register writes take fewer HAL calls, and the chips see the same
+ *  transactions either way. A HAL without the hooks, or a CSN the backend does not own, falls
+ *  back to the GPIO.
+ */
+#define ROUNDS (10u)
+
+typedef struct {
+    const char *name;
+    uint32_t    spi_calls;
+    uint32_t    transactions;
+    uint32_t    bytes;
+    uint32_t    gpio_writes;
+    uint32_t    ce_writes;
+    uint64_t    ns;
+} run_t;
+
+static const uint8_t ping_address[5u] = { '1', 'N', 'o', 'd', 'e' };
+static const uint8_t pong_address[5u] = { '2', 'N', 'o', 'd', 'e' };
+
+static nrf24_t *open_radio(uint8_t csn, uint8_t pins, const uint8_t *tx, const uint8_t *rx, spi_handle_t **spi){
+    nrf24_cfg_t cfg   = NRF24_DEFAULT_CFG(csn, pins);
+    nrf24_t    *radio = NULL;
+
+    CHECK((*spi = machine->spi.open(0u, 10000000u, 0u)) != NULL);
+    sim_wire(sim_chip(*spi), pins, (uint8_t)(pins + 1u));
+
+    CHECK(nRF24_init(&radio, *spi, &cfg) == NRF24_OK);
+
+    /* Retuned at runtime, the changed registers go out as one batch. */
+    cfg.channel       = 90u;
+    cfg.retries.count = 5u;
+    CHECK(nRF24_applyConfig(radio, &cfg) == NRF24_OK);
+
+    CHECK(nRF24_openWritingPipe(radio, tx) == NRF24_OK);
+    CHECK(nRF24_openReadingPipe(radio, 1u, rx) == NRF24_OK);
+    return radio;
+}
+
+/* from is listening, stops, sends seq to to and listens again, with the standard or fast switch. */
+static void hop(nrf24_t *from, nrf24_t *to, uint32_t seq, bool fast){
+    uint8_t buffer[32u];
+
+    (void)memset(buffer, 0, sizeof(buffer));
+    (void)memcpy(buffer, &seq, sizeof(seq));
+
+    CHECK((fast ? nRF24_fastStopListening(from) : nRF24_stopListening(from)) == NRF24_OK);
+    CHECK(nRF24_write(from, buffer, sizeof(buffer), false) == NRF24_OK);
+    CHECK((fast ? nRF24_fastStartListening(from) : nRF24_startListening(from)) == NRF24_OK);
+
+    (void)memset(buffer, 0, sizeof(buffer));
+    CHECK(nRF24_available(to));
+    CHECK(nRF24_read(to, buffer, sizeof(buffer)) == NRF24_OK);
+    CHECK(memcmp(buffer, &seq, sizeof(seq)) == 0);
+}
+
+static void run(run_t *r, const machine_t *hal, uint8_t ping_csn, uint8_t pong_csn){
+    spi_handle_t *ping_spi  = NULL;
+    spi_handle_t *pong_spi  = NULL;
+    sim_chip_t   *ping_chip = NULL;
+    sim_chip_t   *pong_chip = NULL;
+    nrf24_t      *ping      = NULL;
+    nrf24_t      *pong      = NULL;
+    uint32_t      gpio      = sim_gpio_writes();
+    uint64_t      start     = sim_now_ns();
+
+    machine   = hal;
+    ping      = open_radio(ping_csn, 1u, ping_address, pong_address, &ping_spi);
+    pong      = open_radio(pong_csn, 4u, pong_address, ping_address, &pong_spi);
+    ping_chip = sim_chip(ping_spi);
+    pong_chip = sim_chip(pong_spi);
+    sim_link(ping_chip, pong_chip);
+
+    CHECK(nRF24_startListening(ping) == NRF24_OK);
+    CHECK(nRF24_startListening(pong) == NRF24_OK);
+    sim_advance_us(NRF24_TPD2STBY_US);
+
+    for (uint32_t seq = 0u; seq < ROUNDS; ++seq){
+        hop(ping, pong, seq, (seq & 1u) != 0u);
+        hop(pong, ping, ~seq, (seq & 1u) != 0u);
+    }
+
+    CHECK(nRF24_deinit(&ping) == NRF24_OK);
+    CHECK(nRF24_deinit(&pong) == NRF24_OK);
+
+    r->spi_calls    = ping_chip->spi_calls + pong_chip->spi_calls;
+    r->transactions = ping_chip->transactions + pong_chip->transactions;
+    r->bytes        = ping_chip->bytes + pong_chip->bytes;
+    r->ce_writes    = ping_chip->gpio_writes + pong_chip->gpio_writes;
+    r->gpio_writes  = sim_gpio_writes() - gpio;
+    r->ns           = sim_now_ns() - start;
+
+    printf("  %-24s %4u SPI calls %4u transactions %4u GPIO writes (%u CE) %8.1f us\r\n", r->name,
+           (unsigned)r->spi_calls, (unsigned)r->transactions, (unsigned)r->gpio_writes, (unsigned)r->ce_writes,
+           (double)r->ns / 1000.0);
+
+    machine->spi.close(ping_spi);
+    machine->spi.close(pong_spi);
+}
+
+int main(void){
+    const machine_t *sim      = NULL;
+    machine_t        no_hooks;
+    run_t            hooks    = { "SPI_HW_CS",               0u, 0u, 0u, 0u, 0u, 0u };
+    run_t            gpio     = { "GPIO CSN, no hooks",      0u, 0u, 0u, 0u, 0u, 0u };
+    run_t            fallback = { "GPIO CSN, hooks refused", 0u, 0u, 0u, 0u, 0u, 0u };
+
+    nRF24_halInit(&sim);
+    no_hooks                = *sim;
+    no_hooks.spi.chipSelect = NULL;
+    no_hooks.spi.batch      = NULL;
+
+    sim_cost.spi_call_ns = 20000u;
+    sim_cost.spi_byte_ns = 800u;
+    sim_cost.gpio_ns     = 5000u;
+
+    run(&hooks, sim, SPI_HW_CS, SPI_HW_CS);
+    run(&gpio, &no_hooks, 0u, 3u);
+    run(&fallback, sim, 0u, 3u);
+
+    /* The chips see the same commands, CSN is released between the batched writes too. */
+    CHECK(hooks.transactions == gpio.transactions);
+    CHECK(hooks.bytes == gpio.bytes);
+    CHECK(hooks.ce_writes == gpio.ce_writes);
+
+    /* Only CE goes through machine->gpio, and a batch is one call for several transactions. */
+    CHECK(hooks.gpio_writes == hooks.ce_writes);
+    CHECK(hooks.spi_calls < hooks.transactions);
+    CHECK(hooks.ns < gpio.ns);
+
+    /* A CSN GPIO write on either side of every transaction, one HAL call each. */
+    CHECK(gpio.gpio_writes >= gpio.ce_writes + (2u * gpio.transactions));
+    CHECK(gpio.spi_calls == gpio.transactions);
+
+    /* chipSelect turns down a CSN that is not SPI_HW_CS, batch is not used then. */
+    CHECK(fallback.spi_calls == gpio.spi_calls);
+    CHECK(fallback.transactions == gpio.transactions);
+    CHECK(fallback.gpio_writes == gpio.gpio_writes);
+
+    printf("chip select ok\r\n");
+    return 0;
+}
@@ -0,0 +1,107 @@
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <span>
+#include <utility>
+
+#include "inc/nRF24.hpp"
+#include "sim.h"
+
+/**
+ * @brief nRF24::Device (C++20) on simulated chips: a Device that is not open, or was moved
+ *  from, refuses every call, an open one writes and reads through spans, and moving it keeps
+ *  the link working.
+ */
+struct Ping : nRF24::Config {
+    static constexpr uint8_t csn             = 0u;
+    static constexpr uint8_t ce              = 1u;
+    static constexpr bool    dynamicPayloads = true;
+};
+
+struct Pong : Ping {
+    static constexpr uint8_t csn = 3u;
+    static constexpr uint8_t ce  = 4u;
+};
+
+static const uint8_t address[5u] = { '1', 'N', 'o', 'd', 'e' };
+
+template <typename C>
+static void open(nRF24::Device &device) {
+    CHECK(device.open<C>(0u, 10000000u, 0u) == NRF24_OK);
+    CHECK(device.handle() != nullptr);
+    sim_wire(sim_chip(device.spi()), C::ce, (uint8_t)(C::ce + 1u));
+}
+
+/* Every call of a Device without a radio returns NRF24_ERROR, nothing reaches the driver. */
+static void check_closed(nRF24::Device &device) {
+    std::array<std::byte, 4u>                      payload{};
+    std::array<std::byte, NRF24_MAX_PAYLOAD_SIZE> storage{};
+    std::span<std::byte>                           received = storage;
+
+    CHECK(device.handle() == nullptr);
+    CHECK(device.write(payload) == NRF24_ERROR);
+    CHECK(device.fastWrite(payload) == NRF24_ERROR);
+    CHECK(device.writeAckPayload(1u, payload) == NRF24_ERROR);
+    CHECK(!device.available());
+    CHECK(device.read(storage, received) == NRF24_ERROR);
+    CHECK(received.empty());
+}
+
+/* from sends to to, to reads it in place. */
+static void exchange(nRF24::Device &from, nRF24::Device &to, uint8_t seq) {
+    std::array<std::byte, 4u>                      payload{};
+    std::array<std::byte, NRF24_MAX_PAYLOAD_SIZE> storage{};
+    std::span<std::byte>                           received;
+
+    payload.fill(std::byte{ seq });
+    CHECK(from.write(payload) == NRF24_OK);
+
+    CHECK(to.available());
+    CHECK(to.read(storage, received) == NRF24_OK);
+    CHECK(received.data() == storage.data());
+    CHECK(received.size() == payload.size());
+    CHECK(std::memcmp(received.data(), payload.data(), payload.size()) == 0);
+}
+
+int main(void) {
+    nRF24_halInit(&machine);
+
+    nRF24::Device ping;
+    nRF24::Device pong;
+
+    check_closed(ping);
+
+    open<Ping>(ping);
+    open<Pong>(pong);
+    sim_link(sim_chip(ping.spi()), sim_chip(pong.spi()));
+
+    CHECK(nRF24_openWritingPipe(ping.handle(), address) == NRF24_OK);
+    CHECK(nRF24_openReadingPipe(pong.handle(), 1u, address) == NRF24_OK);
+    CHECK(nRF24_startListening(pong.handle()) == NRF24_OK);
+    CHECK(nRF24_stopListening(ping.handle()) == NRF24_OK);
+
+    std::array<std::byte, NRF24_MAX_PAYLOAD_SIZE + 1u> oversized{};
+    CHECK(ping.write(oversized) == NRF24_ARG_INVALID);
+
+    exchange(ping, pong, 1u);
+
+    /* Move construction takes the radio, the moved from Device is closed. */
+    nRF24::Device moved(std::move(ping));
+    check_closed(ping);
+    exchange(moved, pong, 2u);
+
+    /* Move assignment too, back into the original. */
+    ping = std::move(moved);
+    check_closed(moved);
+    exchange(ping, pong, 3u);
+
+    /* close() releases the radio, a second close() is harmless. */
+    pong.close();
+    pong.close();
+    check_closed(pong);
+
+    std::printf("device ok\r\n");
+    return 0;
+}
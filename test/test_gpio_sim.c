@@ -0,0 +1,145 @@
+#include "stdint.h"
+#include "stdbool.h"
+#include "stdio.h"
+#include "string.h"
+#include "errno.h"
+#include "unistd.h"
+#include "fcntl.h"
+#include "sys/stat.h"
+
+#include "inc/hal/config.h"
+#include "inc/hal/machine.h"
+#include "sim.h"
+
+/**
+ * @brief The gpiochip backend of the Linux HAL against a gpio-sim chip: line request, 
+ *  output values and falling edge events. Skipped when configfs or gpio-sim is missing 
+ *  (modprobe gpio-sim) or without the rights to create a chip. 
+ * 
+ * machine.c is built with GPIO_CHIP_PATH pointing at GPIO_SIM_DIR/gpiochip%u (short, the HAL 
+ *  formats it into MAX_PATH_LENGTH), the test links gpiochip0 there to the simulated chip. Line values are set through the pull 
+ *  attribute of the simulator and read back from its value attribute. 
+ */
+#define CONFIGFS "/sys/kernel/config/gpio-sim"
+#define CHIP     CONFIGFS "/nrf24-test"
+#define BANK     CHIP "/bank0"
+
+#define CE_PIN  (1u)
+#define IRQ_PIN (2u)
+
+static char sysfs[128u];
+
+static bool put(const char *path, const char *value){
+    int  fd = open(path, O_WRONLY);
+    bool ok = (fd >= 0) && (write(fd, value, strlen(value)) == (ssize_t)strlen(value));
+
+    if (fd >= 0){
+        (void)close(fd);
+    }
+    return ok;
+}
+
+static bool get(const char *path, char *value, size_t size){
+    int     fd     = open(path, O_RDONLY);
+    ssize_t length = (fd >= 0) ? read(fd, value, size - 1u) : -1;
+
+    if (fd >= 0){
+        (void)close(fd);
+    }
+    if (length <= 0){
+        return false;
+    }
+    value[length] = '\0';
+    value[strcspn(value, "\n")] = '\0';
+    return true;
+}
+
+static bool line_value(uint8_t line){
+    char path[192u];
+    char value[8u];
+
+    (void)snprintf(path, sizeof(path), "%s/sim_gpio%u/value", sysfs, (unsigned)line);
+    CHECK(get(path, value, sizeof(value)));
+    return strcmp(value, "1") == 0;
+}
+
+static void line_pull(uint8_t line, const char *pull){
+    char path[192u];
+
+    (void)snprintf(path, sizeof(path), "%s/sim_gpio%u/pull", sysfs, (unsigned)line);
+    CHECK(put(path, pull));
+}
+
+static void teardown(void){
+    (void)put(CHIP "/live", "0");
+    (void)rmdir(BANK);
+    (void)rmdir(CHIP);
+    (void)unlink(GPIO_SIM_DIR "/gpiochip0");
+    (void)rmdir(GPIO_SIM_DIR);
+}
+
+/* A live gpio-sim chip with one bank of 8 lines, sysfs is the directory of its lines. */
+static bool setup(void){
+    char chip[32u];
+    char device[32u];
+    char path[64u];
+
+    teardown();
+    if ((mkdir(CHIP, 0755) != 0) || (mkdir(BANK, 0755) != 0) || !put(BANK "/num_lines", "8") || 
+        !put(CHIP "/live", "1") || !get(BANK "/chip_name", chip, sizeof(chip)) || 
+        !get(CHIP "/dev_name", device, sizeof(device))){
+        printf("gpio-sim not available (%s), skipped\r\n", strerror(errno));
+        teardown();
+        return false;
+    }
+
+    (void)snprintf(sysfs, sizeof(sysfs), "/sys/devices/platform/%s/%s", device, chip);
+    (void)snprintf(path, sizeof(path), "/dev/%s", chip);
+    CHECK(mkdir(GPIO_SIM_DIR, 0755) == 0);
+    CHECK(symlink(path, GPIO_SIM_DIR "/gpiochip0") == 0);
+    return true;
+}
+
+static void on_edge(void *arg){
+    (*(uint32_t *)arg)++;
+}
+
+int main(void){
+    uint32_t edges = 0u;
+
+    if (!setup()){
+        return SIM_SKIP;
+    }
+    nRF24_halInit(&machine);
+
+    /* Line request and output. */
+    CHECK(machine->gpio.config(CE_PIN, true) == 0);
+    CHECK(machine->gpio.write(CE_PIN, HIGH) >= 0);
+    CHECK(line_value(CE_PIN));
+    CHECK(machine->gpio.write(CE_PIN, LOW) >= 0);
+    CHECK(!line_value(CE_PIN));
+
+    /* Falling edges only, like the IRQ of the nRF24. */
+    line_pull(IRQ_PIN, "pull-up");
+    CHECK(machine->gpio.attachInterrupt(IRQ_PIN, on_edge, &edges) == 0);
+    CHECK(machine->gpio.interruptFd(IRQ_PIN) >= 0);
+    CHECK(machine->gpio.read(IRQ_PIN));
+    CHECK(machine->gpio.waitInterrupt(IRQ_PIN, 0u) == 0);
+
+    line_pull(IRQ_PIN, "pull-down");
+    CHECK(machine->gpio.waitInterrupt(IRQ_PIN, 1000u) == 1);
+    CHECK(edges == 1u);
+    CHECK(!machine->gpio.read(IRQ_PIN));
+
+    line_pull(IRQ_PIN, "pull-up");
+    CHECK(machine->gpio.waitInterrupt(IRQ_PIN, 50u) == 0);
+    CHECK(edges == 1u);
+
+    CHECK(machine->gpio.detachInterrupt(IRQ_PIN) == 0);
+    CHECK(machine->gpio.interruptFd(IRQ_PIN) < 0);
+    CHECK(machine->gpio.waitInterrupt(IRQ_PIN, 0u) < 0);
+
+    teardown();
+    printf("gpio-sim ok, %s\r\n", sysfs);
+    return 0;
+}
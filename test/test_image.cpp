@@ -0,0 +1,109 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <type_traits>
+#include <utility>
+
+#include "inc/nRF24.hpp"
+#include "sim.h"
+
+/**
+ * @brief nRF24::Radio<C>: move only, and the register image computed by the compiler leaves a
+ *  chip exactly as nRF24_applyConfig does for the same cfg.
+ */
+struct Defaults : nRF24::Config {
+    static constexpr uint8_t csn = 0u;
+    static constexpr uint8_t ce  = 1u;
+};
+
+struct Custom : nRF24::Config {
+    static constexpr uint8_t           csn             = 3u;
+    static constexpr uint8_t           ce              = 4u;
+    static constexpr uint8_t           addressWidth    = 3u;
+    static constexpr uint8_t           payloadSize     = 12u;
+    static constexpr uint8_t           channel         = 110u;
+    static constexpr nrf24_datarate_t  datarate        = NRF24_250KBPS;
+    static constexpr nrf24_crclength_t crc             = NRF24_CRC_8;
+    static constexpr bool              dynamicPayloads = true;
+    static constexpr uint8_t           retryDelay      = 9u;
+    static constexpr uint8_t           retryCount      = 4u;
+    static constexpr bool              ackPayload      = true;
+    static constexpr nrf24_pa_dbm_t    paLevel         = NRF24_PA_HIGH;
+    static constexpr bool              lnaEnabled      = false;
+};
+
+struct NoAck : nRF24::Config {
+    static constexpr uint8_t           csn      = 6u;
+    static constexpr uint8_t           ce       = 7u;
+    static constexpr nrf24_datarate_t  datarate = NRF24_2MBPS;
+    static constexpr nrf24_crclength_t crc      = NRF24_CRC_DISABLED;
+    static constexpr bool              autoAck  = false;
+};
+
+static_assert(!std::is_copy_constructible_v<nRF24::Radio<Defaults>>, "Radio owns its handle, it must not be copied");
+static_assert(!std::is_copy_assignable_v<nRF24::Radio<Defaults>>, "Radio owns its handle, it must not be copied");
+static_assert(std::is_nothrow_move_constructible_v<nRF24::Radio<Defaults>>, "Radio is movable");
+static_assert(std::is_nothrow_move_assignable_v<nRF24::Radio<Defaults>>, "Radio is movable");
+
+/* The chip registers the image covers, CONFIG without PWR_UP and PRIM_RX (left to the driver). */
+static uint8_t chip_reg(const sim_chip_t *chip, uint8_t reg) {
+    return (reg == NRF_CONFIG) ? (uint8_t)(chip->regs[reg] & ~(_BV(PWR_UP) | _BV(PRIM_RX))) : chip->regs[reg];
+}
+
+/* Radio<C>::init on one chip, nRF24_init with other defaults and then nRF24_applyConfig(C's cfg)
+    on another, the image registers must end up equal. */
+template <typename C, typename Other>
+static void check_image(void) {
+    nRF24::Radio<C> radio;
+    nrf24_t        *applied = nullptr;
+    spi_handle_t   *spi_a   = machine->spi.open(0u, 10000000u, 0u);
+    spi_handle_t   *spi_b   = machine->spi.open(0u, 10000000u, 0u);
+    nrf24_cfg_t     cfg     = nRF24::Radio<C>::cfg;
+
+    CHECK((spi_a != nullptr) && (spi_b != nullptr));
+    CHECK(radio.init(spi_a) == NRF24_OK);
+
+    cfg.gpio = nRF24::Radio<Other>::cfg.gpio;
+    CHECK(nRF24_init(&applied, spi_b, &nRF24::Radio<Other>::cfg) == NRF24_OK);
+    CHECK(nRF24_applyConfig(applied, &cfg) == NRF24_OK);
+
+    for (const nrf24_reg_write_t &write : nRF24::Radio<C>::image) {
+        if (chip_reg(sim_chip(spi_a), write.reg) != chip_reg(sim_chip(spi_b), write.reg)) {
+            std::printf("register 0x%02X: image 0x%02X, applyConfig 0x%02X\r\n", (unsigned)write.reg,
+                        (unsigned)chip_reg(sim_chip(spi_a), write.reg), (unsigned)chip_reg(sim_chip(spi_b), write.reg));
+        }
+        CHECK(chip_reg(sim_chip(spi_a), write.reg) == chip_reg(sim_chip(spi_b), write.reg));
+        CHECK(chip_reg(sim_chip(spi_a), write.reg) == write.value);
+    }
+
+    /* Moving hands the radio over, the destructor of the owner releases it. */
+    nrf24_t *handle = radio.handle();
+    {
+        nRF24::Radio<C> owner(std::move(radio));
+        CHECK(radio.handle() == nullptr);
+        CHECK(owner.handle() == handle);
+    }
+
+    CHECK(nRF24_deinit(&applied) == NRF24_OK);
+    machine->spi.close(spi_a);
+    machine->spi.close(spi_b);
+}
+
+int main(void) {
+    nRF24_halInit(&machine);
+
+    check_image<Defaults, Custom>();
+    check_image<Custom, Defaults>();
+    check_image<NoAck, Custom>();
+
+    /* Every radio was released, so all NRF24_MAX_INSTANCES can be claimed again. */
+    nRF24::Radio<Defaults> radios[NRF24_MAX_INSTANCES];
+    spi_handle_t          *spis[NRF24_MAX_INSTANCES];
+    for (size_t i = 0u; i < NRF24_MAX_INSTANCES; ++i) {
+        spis[i] = machine->spi.open(0u, 10000000u, 0u);
+        CHECK(radios[i].init(spis[i]) == NRF24_OK);
+    }
+
+    std::printf("image ok\r\n");
+    return 0;
+}
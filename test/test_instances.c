@@ -0,0 +1,91 @@
+#include "stdint.h"
+#include "stdbool.h"
+#include "stdio.h"
+#include "pthread.h"
+#include "stdatomic.h"
+
+#include "inc/nRF24.h"
+#include "sim.h"
+
+/**
+ * @brief More threads than radio_pool slots call nRF24_init at once, every round exactly 
+ *  NRF24_MAX_INSTANCES get a radio, no two the same, and each drives its own chip. 
+ */
+#define THREADS (NRF24_MAX_INSTANCES + 4u)
+#define ROUNDS  (50u)
+
+static pthread_barrier_t barrier;
+static spi_handle_t     *spi[THREADS];
+static nrf24_t          *radios[THREADS];
+static atomic_uint       opened;
+
+static void *worker(void *arg){
+    uint8_t     id     = (uint8_t)(uintptr_t)arg;
+    nrf24_cfg_t cfg    = NRF24_DEFAULT_CFG((uint8_t)(id * 2u), (uint8_t)(id * 2u + 1u));
+    sim_chip_t *chip   = sim_chip(spi[id]);
+    bool        linked = false;
+
+    cfg.channel = (uint8_t)(10u + id);
+
+    for (uint32_t round = 0u; round < ROUNDS; ++round){
+        (void)pthread_barrier_wait(&barrier);
+
+        if (nRF24_init(&radios[id], spi[id], &cfg) == NRF24_OK){
+            (void)atomic_fetch_add(&opened, 1u);
+            CHECK(nRF24_isConnected(radios[id], &linked) == NRF24_OK);
+            CHECK(linked);
+            CHECK(nRF24_setPayloadSize(radios[id], (uint8_t)(id + 1u)) == NRF24_OK);
+            CHECK(chip->regs[RF_CH] == cfg.channel);
+            CHECK(chip->regs[RX_PW_P0] == (uint8_t)(id + 1u));
+        } else {
+            radios[id] = NULL;
+        }
+
+        /* Main checks the handles. */
+        (void)pthread_barrier_wait(&barrier);
+        (void)pthread_barrier_wait(&barrier);
+
+        if (radios[id] != NULL){
+            CHECK(nRF24_deinit(&radios[id]) == NRF24_OK);
+            CHECK(radios[id] == NULL);
+        }
+    }
+    return NULL;
+}
+
+int main(void){
+    pthread_t threads[THREADS];
+
+    nRF24_halInit(&machine);
+    CHECK(pthread_barrier_init(&barrier, NULL, THREADS + 1u) == 0);
+
+    for (uint32_t i = 0u; i < THREADS; ++i){
+        CHECK((spi[i] = machine->spi.open(0u, 10000000u, 0u)) != NULL);
+        sim_wire(sim_chip(spi[i]), (uint8_t)(i * 2u + 1u), (uint8_t)(100u + i));
+    }
+    for (uint32_t i = 0u; i < THREADS; ++i){
+        CHECK(pthread_create(&threads[i], NULL, worker, (void *)(uintptr_t)i) == 0);
+    }
+
+    for (uint32_t round = 0u; round < ROUNDS; ++round){
+        atomic_store(&opened, 0u);
+        (void)pthread_barrier_wait(&barrier);
+        (void)pthread_barrier_wait(&barrier);
+
+        CHECK(atomic_load(&opened) == NRF24_MAX_INSTANCES);
+        for (uint32_t i = 0u; i < THREADS; ++i){
+            for (uint32_t j = i + 1u; j < THREADS; ++j){
+                CHECK((radios[i] == NULL) || (radios[i] != radios[j]));
+            }
+        }
+        (void)pthread_barrier_wait(&barrier);
+    }
+
+    for (uint32_t i = 0u; i < THREADS; ++i){
+        CHECK(pthread_join(threads[i], NULL) == 0);
+        machine->spi.close(spi[i]);
+    }
+    printf("%u rounds, %u of %u threads got a radio each round\r\n", 
+           (unsigned)ROUNDS, (unsigned)NRF24_MAX_INSTANCES, (unsigned)THREADS);
+    return 0;
+}
@@ -0,0 +1,51 @@
+#include "stdint.h"
+#include "stdbool.h"
+#include "stdio.h"
+
+#include "inc/nRF24.h"
+#include "sim.h"
+
+/**
+ * @brief nRF24_attachIrq and nRF24_deinit with HALs that lack the optional interrupt hooks. 
+ */
+static void notify(void *arg){
+    (*(uint32_t *)arg)++;
+}
+
+static void test_hal(const machine_t *hal, bool attach){
+    nrf24_cfg_t   cfg   = NRF24_DEFAULT_CFG(0u, 1u);
+    spi_handle_t *spi   = NULL;
+    nrf24_t      *radio = NULL;
+    uint32_t      count = 0u;
+
+    machine = hal;
+    CHECK((spi = machine->spi.open(0u, 10000000u, 0u)) != NULL);
+    sim_wire(sim_chip(spi), 1u, 2u);
+
+    CHECK(nRF24_init(&radio, spi, &cfg) == NRF24_OK);
+    CHECK(nRF24_attachIrq(radio, 2u, notify, &count) == (attach ? NRF24_OK : NRF24_ERROR));
+    CHECK((sim_chip(spi)->irq_callback != NULL) == attach);
+    CHECK(nRF24_deinit(&radio) == NRF24_OK);
+
+    machine->spi.close(spi);
+}
+
+int main(void){
+    const machine_t *sim      = NULL;
+    machine_t        no_detach;
+    machine_t        no_irq;
+
+    nRF24_halInit(&sim);
+    no_detach = *sim;
+    no_irq    = *sim;
+    no_detach.gpio.detachInterrupt = NULL;
+    no_irq.gpio.attachInterrupt    = NULL;
+    no_irq.gpio.detachInterrupt    = NULL;
+
+    test_hal(sim, true);
+    test_hal(&no_detach, true);
+    test_hal(&no_irq, false);
+
+    printf("irq hooks ok\r\n");
+    return 0;
+}
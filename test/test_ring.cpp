@@ -0,0 +1,78 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "inc/nRF24.h"
+#include "inc/nRF24_ring.h"
+#include "sim.h"
+
+/**
+ * @brief nRF24_ring.h from C++: the layout matches the one the C driver was built with 
+ *  (ring_c.c), and a C++ consumer drains what nRF24_ringFill put in. 
+ */
+extern "C" const size_t ring_layout_c[];
+extern "C" nrf24_t     *ring_open_radio(uint8_t pins, sim_chip_t **chip);
+
+static const uint8_t address[5u] = { '1', 'N', 'o', 'd', 'e' };
+
+int main(void){
+    const size_t layout[] = {
+        sizeof(nrf24_ring_t),
+        alignof(nrf24_ring_t),
+        offsetof(nrf24_ring_t, head),
+        offsetof(nrf24_ring_t, tail_cache),
+        offsetof(nrf24_ring_t, dropped),
+        offsetof(nrf24_ring_t, tail),
+        offsetof(nrf24_ring_t, head_cache)
+    };
+    static nrf24_rx_frame_t slots[4u];
+    static nrf24_ring_t     ring;
+    sim_chip_t             *rx_chip  = nullptr;
+    sim_chip_t             *tx_chip  = nullptr;
+    nrf24_t                *rx       = nullptr;
+    nrf24_t                *tx       = nullptr;
+    nrf24_rx_frame_t       *frame    = nullptr;
+    uint8_t                 payload[32u];
+    uint8_t                 expected = 0u;
+
+    for (size_t i = 0u; i < (sizeof(layout) / sizeof(layout[0u])); ++i){
+        CHECK(layout[i] == ring_layout_c[i]);
+    }
+    CHECK((offsetof(nrf24_ring_t, tail) - offsetof(nrf24_ring_t, head)) >= NRF24_CACHE_LINE);
+
+    nRF24_halInit(&machine);
+    rx = ring_open_radio(0u, &rx_chip);
+    tx = ring_open_radio(3u, &tx_chip);
+    sim_link(rx_chip, tx_chip);
+
+    CHECK(nRF24_ringInit(&ring, slots, 4u) == NRF24_OK);
+    CHECK(nRF24_openReadingPipe(rx, 1u, address) == NRF24_OK);
+    CHECK(nRF24_startListening(rx) == NRF24_OK);
+    CHECK(nRF24_openWritingPipe(tx, address) == NRF24_OK);
+    CHECK(nRF24_stopListening(tx) == NRF24_OK);
+
+    /* 6 frames through a 4 slot ring, drained in between. */
+    for (uint8_t round = 0u; round < 2u; ++round){
+        for (uint8_t i = 0u; i < 3u; ++i){
+            std::memset(payload, (int)(round * 3u + i), sizeof(payload));
+            CHECK(nRF24_write(tx, payload, sizeof(payload), false) == NRF24_OK);
+        }
+        CHECK(nRF24_ringFill(rx, &ring) == NRF24_OK);
+        CHECK(nRF24_ringCount(&ring) == 3u);
+
+        while ((frame = nRF24_ringPeek(&ring)) != nullptr){
+            CHECK((frame->pipe == 1u) && (frame->length == sizeof(payload)));
+            CHECK((frame->data[0u] == expected) && (frame->data[31u] == expected));
+            nRF24_ringRelease(&ring);
+            expected++;
+        }
+    }
+    CHECK(expected == 6u);
+    CHECK(nRF24_ringDropped(&ring) == 0u);
+
+    CHECK(nRF24_deinit(&rx) == NRF24_OK);
+    CHECK(nRF24_deinit(&tx) == NRF24_OK);
+    std::printf("ring ok from C++, %zu bytes\r\n", sizeof(nrf24_ring_t));
+    return 0;
+}
@@ -0,0 +1,87 @@
+#include "stdint.h"
+#include "stdbool.h"
+#include "stdio.h"
+
+#include "inc/nRF24.h"
+#include "sim.h"
+
+/**
+ * @brief nrf24_stats_t.rx_full counts the RX FIFO filling up, not the polls that find it full.
+ */
+static const uint8_t address[5u] = { '1', 'N', 'o', 'd', 'e' };
+static const uint8_t payload[8u] = { 1u, 2u, 3u, 4u, 5u, 6u, 7u, 8u };
+
+static nrf24_t *open_radio(uint8_t pins, sim_chip_t **chip){
+    nrf24_cfg_t   cfg   = NRF24_DEFAULT_CFG(pins, (uint8_t)(pins + 1u));
+    spi_handle_t *spi   = machine->spi.open(0u, 10000000u, 0u);
+    nrf24_t      *radio = NULL;
+
+    CHECK(spi != NULL);
+    *chip = sim_chip(spi);
+    sim_wire(*chip, (uint8_t)(pins + 1u), (uint8_t)(pins + 2u));
+
+    CHECK(nRF24_init(&radio, spi, &cfg) == NRF24_OK);
+    return radio;
+}
+
+static uint32_t rx_full(nrf24_t *radio){
+    nrf24_stats_t stats;
+
+    CHECK(nRF24_getStats(radio, &stats) == NRF24_OK);
+    return stats.rx_full;
+}
+
+int main(void){
+    sim_chip_t       *ptx_chip = NULL;
+    sim_chip_t       *prx_chip = NULL;
+    nrf24_t          *ptx      = NULL;
+    nrf24_t          *prx      = NULL;
+    nrf24_rx_frame_t  frames[3u];
+    size_t            count    = 0u;
+
+    nRF24_halInit(&machine);
+    ptx = open_radio(0u, &ptx_chip);
+    prx = open_radio(3u, &prx_chip);
+    sim_link(ptx_chip, prx_chip);
+
+    CHECK(nRF24_openWritingPipe(ptx, address) == NRF24_OK);
+    CHECK(nRF24_openReadingPipe(prx, 1u, address) == NRF24_OK);
+    CHECK(nRF24_startListening(prx) == NRF24_OK);
+    CHECK(nRF24_stopListening(ptx) == NRF24_OK);
+
+    for (uint8_t i = 0u; i < 3u; ++i){
+        CHECK(nRF24_write(ptx, payload, sizeof(payload), false) == NRF24_OK);
+    }
+    CHECK(prx_chip->rx_count == 3u);
+
+    /* Polling a full FIFO (readBurst reads FIFO_STATUS first) counts once. */
+    for (uint8_t i = 0u; i < 10u; ++i){
+        CHECK(nRF24_readBurst(prx, frames, 0u, &count) == NRF24_OK);
+    }
+    CHECK(rx_full(prx) == 1u);
+
+    /* Drained by one and filled again, a second time. */
+    CHECK(nRF24_readBurst(prx, frames, 1u, &count) == NRF24_OK);
+    CHECK((count == 1u) && (prx_chip->rx_count == 2u));
+    CHECK(nRF24_readBurst(prx, frames, 0u, &count) == NRF24_OK);
+    CHECK(rx_full(prx) == 1u);
+
+    CHECK(nRF24_write(ptx, payload, sizeof(payload), false) == NRF24_OK);
+    CHECK(nRF24_readBurst(prx, frames, 1u, &count) == NRF24_OK);
+    CHECK(nRF24_readBurst(prx, frames, 0u, &count) == NRF24_OK);
+    CHECK(rx_full(prx) == 2u);
+
+    /* A flush empties it too. */
+    CHECK(nRF24_write(ptx, payload, sizeof(payload), false) == NRF24_OK);
+    CHECK(nRF24_flushRx(prx) == NRF24_OK);
+    for (uint8_t i = 0u; i < 3u; ++i){
+        CHECK(nRF24_write(ptx, payload, sizeof(payload), false) == NRF24_OK);
+    }
+    CHECK(nRF24_readBurst(prx, frames, 3u, &count) == NRF24_OK);
+    CHECK((count == 3u) && (rx_full(prx) == 3u));
+
+    CHECK(nRF24_deinit(&ptx) == NRF24_OK);
+    CHECK(nRF24_deinit(&prx) == NRF24_OK);
+    printf("stats ok\r\n");
+    return 0;
+}
@@ -0,0 +1,144 @@
+#include "stdint.h"
+#include "stdbool.h"
+#include "stdio.h"
+
+#include "inc/nRF24.h"
+#include "sim.h"
+
+/**
+ * @brief The mode switches against the simulated clock: CE never goes high within Tpd2stby 
+ *  of power up (sim_chip_t.ce_early), a turnaround does not shorten that window, and 
+ *  POWERING_UP only ends with it. A passed window stays passed however long the radio idles. 
+ */
+static const uint8_t address[5u] = { '1', 'N', 'o', 'd', 'e' };
+static const uint8_t payload[8u] = { 1u, 2u, 3u, 4u, 5u, 6u, 7u, 8u };
+
+static uint8_t pins = 0u;
+
+static nrf24_t *open_radio(sim_chip_t **chip){
+    nrf24_cfg_t   cfg   = NRF24_DEFAULT_CFG(pins, (uint8_t)(pins + 1u));
+    spi_handle_t *spi   = machine->spi.open(0u, 10000000u, 0u);
+    nrf24_t      *radio = NULL;
+
+    /* No receiver in these tests, so the writes complete without an ACK. */
+    cfg.ack.autoAck = false;
+    
+    CHECK(spi != NULL);
+    *chip = sim_chip(spi);
+    sim_wire(*chip, (uint8_t)(pins + 1u), (uint8_t)(pins + 2u));
+    pins = (uint8_t)(pins + 3u);
+
+    CHECK(nRF24_init(&radio, spi, &cfg) == NRF24_OK);
+    CHECK(nRF24_openWritingPipe(radio, address) == NRF24_OK);
+    return radio;
+}
+
+static nrf24_state_t state_of(nrf24_t *radio){
+    nrf24_state_t state = NRF24_STATE_POWER_DOWN;
+
+    CHECK(nRF24_getState(radio, &state, NULL) == NRF24_OK);
+    return state;
+}
+
+/* The first write after init waits for Tpd2stby, not just for the turnaround. */
+static void test_write_after_init(nrf24_status_t (*stop)(nrf24_t *radio)){
+    sim_chip_t *chip     = NULL;
+    nrf24_t    *radio    = open_radio(&chip);
+    uint32_t    ready_at = 0u;
+
+    CHECK(state_of(radio) == NRF24_STATE_POWERING_UP);
+    CHECK(stop(radio) == NRF24_OK);
+    CHECK(state_of(radio) == NRF24_STATE_POWERING_UP);
+    CHECK(nRF24_getState(radio, &(nrf24_state_t){ 0 }, &ready_at) == NRF24_OK);
+    CHECK(ready_at == (uint32_t)(chip->powered_at / 1000u) + NRF24_TPD2STBY_US);
+
+    CHECK(nRF24_write(radio, payload, sizeof(payload), false) == NRF24_OK);
+    CHECK(chip->ce_early == 0u);
+    CHECK((sim_now_ns() - chip->powered_at) >= ((uint64_t)NRF24_TPD2STBY_US * 1000u));
+    CHECK(state_of(radio) != NRF24_STATE_POWERING_UP);
+
+    CHECK(nRF24_deinit(&radio) == NRF24_OK);
+}
+
+/* CE low does not end POWERING_UP, only the passing of Tpd2stby does. */
+static void test_powering_up(void){
+    sim_chip_t *chip  = NULL;
+    nrf24_t    *radio = open_radio(&chip);
+    uint64_t    left  = (chip->powered_at + ((uint64_t)NRF24_TPD2STBY_US * 1000u)) - sim_now_ns();
+
+    CHECK(nRF24_stopListening(radio) == NRF24_OK);
+    CHECK(state_of(radio) == NRF24_STATE_POWERING_UP);
+
+    sim_advance_us((uint32_t)(left / 1000u) - 1u);
+    CHECK(state_of(radio) == NRF24_STATE_POWERING_UP);
+    CHECK(!nRF24_isReady(radio));
+
+    sim_advance_us(1u);
+    CHECK(nRF24_isReady(radio));
+    CHECK(state_of(radio) == NRF24_STATE_STANDBY);
+
+    CHECK(nRF24_deinit(&radio) == NRF24_OK);
+}
+
+/* Once powered up, a turnaround is only the txDelay and RX only settles for Tstby2a. */
+static void test_turnaround(nrf24_status_t (*start)(nrf24_t *radio), nrf24_status_t (*stop)(nrf24_t *radio)){
+    sim_chip_t *chip     = NULL;
+    nrf24_t    *radio    = open_radio(&chip);
+    uint32_t    ready_at = 0u;
+    uint32_t    now      = 0u;
+
+    sim_advance_us(NRF24_TPD2STBY_US);
+    CHECK(start(radio) == NRF24_OK);
+    CHECK(state_of(radio) == NRF24_STATE_RX_SETTLING);
+    sim_advance_us(NRF24_TSTBY2A_US);
+    CHECK(state_of(radio) == NRF24_STATE_RX);
+
+    sim_advance_us(1000u);
+    CHECK(stop(radio) == NRF24_OK);
+    now = machine->time.micros();
+    CHECK(nRF24_getState(radio, &(nrf24_state_t){ 0 }, &ready_at) == NRF24_OK);
+    CHECK(((int32_t)(ready_at - now) > 0) && ((ready_at - now) <= 505u));
+
+    CHECK(nRF24_write(radio, payload, sizeof(payload), false) == NRF24_OK);
+    CHECK(chip->ce_early == 0u);
+    CHECK((int32_t)(machine->time.micros() - ready_at) >= 0);
+
+    CHECK(nRF24_deinit(&radio) == NRF24_OK);
+}
+
+/* A window that passed long ago must not read as pending again once micros has moved on 
+    by 2^31 us, writing after a long idle does not sleep. */
+static void test_idle_wrap(void){
+    sim_chip_t *chip  = NULL;
+    nrf24_t    *radio = open_radio(&chip);
+    uint64_t    start = 0u;
+
+    CHECK(nRF24_write(radio, payload, sizeof(payload), false) == NRF24_OK);
+    CHECK(nRF24_stopListening(radio) == NRF24_OK);
+    sim_advance_us(NRF24_TPD2STBY_US);
+    CHECK(nRF24_isReady(radio));
+
+    sim_advance_us(0x80000000u + 1000u);
+    CHECK(nRF24_isReady(radio));
+    CHECK(state_of(radio) == NRF24_STATE_STANDBY);
+
+    start = sim_now_ns();
+    CHECK(nRF24_write(radio, payload, sizeof(payload), false) == NRF24_OK);
+    CHECK((sim_now_ns() - start) < ((uint64_t)NRF24_TSTBY2A_US * 1000u));
+
+    CHECK(nRF24_deinit(&radio) == NRF24_OK);
+}
+
+int main(void){
+    nRF24_halInit(&machine);
+
+    test_write_after_init(nRF24_stopListening);
+    test_write_after_init(nRF24_fastStopListening);
+    test_powering_up();
+    test_turnaround(nRF24_startListening, nRF24_stopListening);
+    test_turnaround(nRF24_fastStartListening, nRF24_fastStopListening);
+    test_idle_wrap();
+
+    printf("timing ok\r\n");
+    return 0;
+}
@@ -0,0 +1,106 @@
+#include "stdint.h"
+#include "stdbool.h"
+#include "stdio.h"
+#include "string.h"
+
+#include "inc/nRF24.h"
+#include "sim.h"
+
+/**
+ * @brief nRF24_writeBatch over a lossy link: the TX FIFO is refilled past its 3 slots, MAX_RT
+ *  rounds are retried and counted from ARC_CNT, payloads that run out of attempts are dropped
+ *  and the ones behind them still go out, in order.
+ *
+ * The PTX loses a full round of msgs[0] and 2 tries of its next (sim_chip_t.drop), the PRX
+ *  takes 3 payloads and then, with its RX FIFO full, no longer acks.
+ */
+#define RETRIES      (3u)
+#define MAX_ATTEMPTS (2u)
+#define MSGS         (6u)
+
+static const uint8_t address[5u] = { '1', 'N', 'o', 'd', 'e' };
+
+static nrf24_t *open_radio(uint8_t pins, sim_chip_t **chip){
+    nrf24_cfg_t   cfg   = NRF24_DEFAULT_CFG(pins, (uint8_t)(pins + 1u));
+    spi_handle_t *spi   = machine->spi.open(0u, 10000000u, 0u);
+    nrf24_t      *radio = NULL;
+
+    cfg.retries.count = RETRIES;
+
+    CHECK(spi != NULL);
+    *chip = sim_chip(spi);
+    sim_wire(*chip, (uint8_t)(pins + 1u), (uint8_t)(pins + 2u));
+
+    CHECK(nRF24_init(&radio, spi, &cfg) == NRF24_OK);
+    return radio;
+}
+
+int main(void){
+    sim_chip_t       *ptx_chip = NULL;
+    sim_chip_t       *prx_chip = NULL;
+    nrf24_t          *ptx      = NULL;
+    nrf24_t          *prx      = NULL;
+    uint8_t           data[MSGS][4u];
+    nrf24_tx_msg_t    msgs[MSGS];
+    nrf24_tx_result_t results[MSGS];
+    nrf24_stats_t     stats;
+    uint8_t           buffer[32u];
+
+    nRF24_halInit(&machine);
+    ptx = open_radio(0u, &ptx_chip);
+    prx = open_radio(3u, &prx_chip);
+    sim_link(ptx_chip, prx_chip);
+
+    CHECK(nRF24_openWritingPipe(ptx, address) == NRF24_OK);
+    CHECK(nRF24_openReadingPipe(prx, 1u, address) == NRF24_OK);
+    CHECK(nRF24_startListening(prx) == NRF24_OK);
+    CHECK(nRF24_stopListening(ptx) == NRF24_OK);
+
+    for (uint8_t i = 0u; i < MSGS; ++i){
+        (void)memset(data[i], (int)('a' + i), sizeof(data[i]));
+        msgs[i] = (nrf24_tx_msg_t){ .buffer = data[i], .length = sizeof(data[i]), .multicast = false };
+    }
+
+    /* A full round (first try + RETRIES) and 2 more tries of msgs[0] are lost. */
+    ptx_chip->drop = (RETRIES + 1u) + 2u;
+    CHECK(nRF24_writeBatch(ptx, msgs, results, MSGS, MAX_ATTEMPTS, 1000u) == NRF24_ERROR);
+    CHECK(ptx_chip->drop == 0u);
+
+    /* msgs[0] hit MAX_RT once, its acked round is at most the 2 lost tries. */
+    CHECK((results[0u].status == NRF24_OK) && (results[0u].attempts == 1u));
+    CHECK((results[0u].retransmits >= RETRIES) && (results[0u].retransmits <= RETRIES + 2u));
+    for (uint8_t i = 1u; i < 3u; ++i){
+        CHECK((results[i].status == NRF24_OK) && (results[i].attempts == 0u) && (results[i].retransmits == 0u));
+    }
+    /* Not acked by the full PRX, dropped after MAX_ATTEMPTS rounds read from ARC_CNT. */
+    for (uint8_t i = 3u; i < MSGS; ++i){
+        CHECK((results[i].status == NRF24_ERROR) && (results[i].attempts == MAX_ATTEMPTS));
+        CHECK(results[i].retransmits == (MAX_ATTEMPTS * RETRIES));
+    }
+    CHECK(ptx_chip->tx_count == 0u);
+
+    /* Every payload loaded went through _onTxPayload, reloads after a flush included. */
+    CHECK(nRF24_getStats(ptx, &stats) == NRF24_OK);
+    CHECK(stats.tx_payloads >= MSGS);
+    CHECK(stats.tx_max_rt == 1u + ((MSGS - 3u) * MAX_ATTEMPTS));
+    CHECK(stats.lost == stats.tx_max_rt);
+
+    /* The acked ones arrived once each, in order. */
+    for (uint8_t i = 0u; i < 3u; ++i){
+        CHECK(nRF24_available(prx));
+        CHECK(nRF24_read(prx, buffer, sizeof(buffer)) == NRF24_OK);
+        CHECK(memcmp(buffer, data[i], sizeof(data[i])) == 0);
+    }
+    CHECK(!nRF24_available(prx));
+
+    /* A drained PRX acks again. */
+    CHECK(nRF24_writeBatch(ptx, msgs, results, 3u, MAX_ATTEMPTS, 1000u) == NRF24_OK);
+    for (uint8_t i = 0u; i < 3u; ++i){
+        CHECK((results[i].status == NRF24_OK) && (results[i].attempts == 0u));
+    }
+
+    CHECK(nRF24_deinit(&ptx) == NRF24_OK);
+    CHECK(nRF24_deinit(&prx) == NRF24_OK);
+    printf("write batch ok\r\n");
+    return 0;
+}